@@ -0,0 +1,214 @@
+/**
+ * @file alloc_tracker.cpp
+ * @brief The replacement global operator new and operator delete behind
+ * alloc_tracker.h.
+ */
+
+// Every block gets a small header in front of it that records the requested
+// size, so operator delete knows how many bytes it is freeing even when the
+// caller does not pass the size. The header also records its distance from
+// the start of the underlying malloc block, because over-aligned allocations
+// (see alignas in unrolled_list.cpp) need a bigger gap to keep the returned
+// pointer aligned.
+
+// operator new may run before main, during thread exit, or inside another
+// allocation, so the per-thread counters are a plain struct of integers. A
+// constant-initialized thread_local like that has no constructor and no
+// destructor, so using it never allocates and never depends on
+// initialization order.
+
+#include "alloc_tracker.h"
+
+// Includes std::max.
+#include <algorithm>
+// Includes std::getenv, std::malloc, std::aligned_alloc and std::free.
+#include <cstdlib>
+// Includes std::cerr, used for reports.
+#include <iostream>
+// Includes std::bad_alloc, std::nothrow_t, std::align_val_t and
+// std::get_new_handler.
+#include <new>
+
+namespace alloc_tracker {
+
+namespace {
+
+// Sits right before every pointer operator new returns.
+struct Header {
+  size_t size_;
+  size_t offset_;
+};
+
+// 16 bytes, so the header keeps malloc's alignment for the pointer after it.
+static_assert(sizeof(Header) == alignof(std::max_align_t), "Header must preserve the default alignment");
+
+thread_local Stats tls_stats{};
+
+Header *HeaderOf(void *ptr) { return static_cast<Header *>(ptr) - 1; }
+
+void Record(size_t size) {
+  Stats &stats = tls_stats;
+  stats.allocations_ += 1;
+  stats.bytes_allocated_ += size;
+  stats.live_bytes_ += static_cast<int64_t>(size);
+  stats.peak_live_bytes_ = std::max(stats.peak_live_bytes_, stats.live_bytes_);
+  stats.size_classes_[SizeClass(size)] += 1;
+}
+
+// Returns nullptr if the memory is not available.
+void *TryAllocate(size_t size, size_t align) {
+  size_t offset = std::max(sizeof(Header), align);
+  void *raw;
+  if (align <= alignof(std::max_align_t)) {
+    raw = std::malloc(offset + size);
+  } else {
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    raw = std::aligned_alloc(align, (offset + size + align - 1) / align * align);
+  }
+  if (raw == nullptr) {
+    return nullptr;
+  }
+  void *ptr = static_cast<char *>(raw) + offset;
+  *HeaderOf(ptr) = Header{size, offset};
+  Record(size);
+  return ptr;
+}
+
+// The standard behaviour of operator new: call the new handler until it
+// makes memory available, and throw std::bad_alloc if there is none.
+void *Allocate(size_t size, size_t align) {
+  // Every allocation must return a distinct pointer, even for size 0.
+  size = std::max<size_t>(size, 1);
+  while (true) {
+    void *ptr = TryAllocate(size, align);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void *AllocateNoThrow(size_t size, size_t align) noexcept {
+  try {
+    return Allocate(size, align);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void Deallocate(void *ptr) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  Header header = *HeaderOf(ptr);
+  Stats &stats = tls_stats;
+  stats.deallocations_ += 1;
+  stats.bytes_freed_ += header.size_;
+  stats.live_bytes_ -= static_cast<int64_t>(header.size_);
+  std::free(static_cast<char *>(ptr) - header.offset_);
+}
+
+void Print(const char *name, const Stats &stats) {
+  std::cerr << "[alloc_tracker] " << name << ": " << stats.allocations_ << " allocations (" << stats.bytes_allocated_
+            << " bytes), " << stats.deallocations_ << " frees (" << stats.bytes_freed_ << " bytes), peak live "
+            << stats.peak_live_bytes_ << " bytes\n";
+}
+
+// Prints the main thread's totals at exit if BOOTCAMP_ALLOC_REPORT is set.
+struct ExitReport {
+  ~ExitReport() {
+    if (std::getenv("BOOTCAMP_ALLOC_REPORT") != nullptr) {
+      Print("main thread total", tls_stats);
+    }
+  }
+};
+
+ExitReport exit_report;
+
+}  // namespace
+
+size_t SizeClass(size_t size) {
+  size_t index = 0;
+  for (size_t limit = 16; index + 1 < kSizeClasses && size > limit; limit *= 2) {
+    index += 1;
+  }
+  return index;
+}
+
+size_t SizeClassLimit(size_t index) { return index + 1 < kSizeClasses ? size_t{16} << index : SIZE_MAX; }
+
+Stats ThreadStats() { return tls_stats; }
+
+ScopedRegion::ScopedRegion(const char *name) : name_(name), start_(tls_stats), outer_peak_(tls_stats.peak_live_bytes_) {
+  // Track the peak of this region alone, from the current live bytes on.
+  tls_stats.peak_live_bytes_ = tls_stats.live_bytes_;
+}
+
+ScopedRegion::~ScopedRegion() {
+  Stats delta = Delta();
+  tls_stats.peak_live_bytes_ = std::max(outer_peak_, tls_stats.peak_live_bytes_);
+  if (name_ != nullptr) {
+    Print(name_, delta);
+  }
+}
+
+Stats ScopedRegion::Delta() const {
+  const Stats &now = tls_stats;
+  Stats delta{};
+  delta.allocations_ = now.allocations_ - start_.allocations_;
+  delta.deallocations_ = now.deallocations_ - start_.deallocations_;
+  delta.bytes_allocated_ = now.bytes_allocated_ - start_.bytes_allocated_;
+  delta.bytes_freed_ = now.bytes_freed_ - start_.bytes_freed_;
+  delta.live_bytes_ = now.live_bytes_ - start_.live_bytes_;
+  delta.peak_live_bytes_ = now.peak_live_bytes_ - start_.live_bytes_;
+  for (size_t i = 0; i < kSizeClasses; i++) {
+    delta.size_classes_[i] = now.size_classes_[i] - start_.size_classes_[i];
+  }
+  return delta;
+}
+
+}  // namespace alloc_tracker
+
+// The replaceable global allocation functions. Every form has to be replaced:
+// a form left out would still allocate with the standard library's version,
+// and its memory could then reach our operator delete without a header.
+
+void *operator new(size_t size) { return alloc_tracker::Allocate(size, alignof(std::max_align_t)); }
+void *operator new[](size_t size) { return alloc_tracker::Allocate(size, alignof(std::max_align_t)); }
+void *operator new(size_t size, std::align_val_t align) {
+  return alloc_tracker::Allocate(size, static_cast<size_t>(align));
+}
+void *operator new[](size_t size, std::align_val_t align) {
+  return alloc_tracker::Allocate(size, static_cast<size_t>(align));
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return alloc_tracker::AllocateNoThrow(size, alignof(std::max_align_t));
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return alloc_tracker::AllocateNoThrow(size, alignof(std::max_align_t));
+}
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+  return alloc_tracker::AllocateNoThrow(size, static_cast<size_t>(align));
+}
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+  return alloc_tracker::AllocateNoThrow(size, static_cast<size_t>(align));
+}
+
+void operator delete(void *ptr) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete(void *ptr, size_t) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept { alloc_tracker::Deallocate(ptr); }
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+  alloc_tracker::Deallocate(ptr);
+}
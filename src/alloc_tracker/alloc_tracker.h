@@ -0,0 +1,89 @@
+/**
+ * @file alloc_tracker.h
+ * @brief Counting heap allocations by replacing the global operator new and
+ * operator delete.
+ */
+
+// Linking alloc_tracker.cpp into an executable replaces every form of the
+// global operator new and operator delete with versions that count what they
+// do, and then defer to malloc and free. Every `new`, and every STL container
+// using std::allocator, goes through them. That lets a program ask questions
+// like "how many allocations does one unordered_map insert cost?".
+
+// The counters are thread local, so counting costs a few non-atomic adds and
+// never contends between threads. The numbers are therefore for the calling
+// thread only. Memory allocated on one thread and freed on another counts as
+// an allocation on the first and a free on the second.
+
+// To opt a CMake target in, call bootcamp_track_allocations(<target>) in
+// CMakeLists.txt, or configure with -DBOOTCAMP_TRACK_ALLOCATIONS=ON to opt in
+// every executable. Setting the environment variable BOOTCAMP_ALLOC_REPORT
+// then prints the main thread's totals when the program exits.
+
+#pragma once
+
+// Includes std::size_t.
+#include <cstddef>
+// Includes fixed width integer types.
+#include <cstdint>
+
+namespace alloc_tracker {
+
+// Allocation sizes are bucketed into size classes: class 0 holds 1 to 16
+// bytes, and each following class doubles the limit, up to 64 KiB. The last
+// class holds everything bigger.
+constexpr size_t kSizeClasses = 14;
+
+// Returns the size class of an allocation of size bytes.
+size_t SizeClass(size_t size);
+
+// Returns the largest allocation size in size class index, or SIZE_MAX for
+// the last class.
+size_t SizeClassLimit(size_t index);
+
+// A snapshot of one thread's counters.
+struct Stats {
+  uint64_t allocations_;
+  uint64_t deallocations_;
+  uint64_t bytes_allocated_;
+  uint64_t bytes_freed_;
+  // Bytes allocated minus bytes freed by this thread. It can be negative if
+  // the thread frees memory that other threads allocated.
+  int64_t live_bytes_;
+  // The highest live_bytes_ has been.
+  int64_t peak_live_bytes_;
+  uint64_t size_classes_[kSizeClasses];
+};
+
+// Returns the calling thread's counters since it started.
+Stats ThreadStats();
+
+// Measures the allocations the calling thread makes during the lifetime of
+// the region. Regions can nest. If the region has a name, its destructor
+// prints a one-line report to std::cerr.
+//
+//   {
+//     alloc_tracker::ScopedRegion region("1000 inserts");
+//     ...
+//     if (region.Delta().allocations_ > 1000) { ... }
+//   }
+class ScopedRegion {
+ public:
+  explicit ScopedRegion(const char *name = nullptr);
+  ~ScopedRegion();
+
+  ScopedRegion(const ScopedRegion &) = delete;
+  ScopedRegion &operator=(const ScopedRegion &) = delete;
+
+  // Returns what happened since the region started. live_bytes_ is the net
+  // change, and peak_live_bytes_ is the highest the live bytes rose above
+  // their value at the start of the region.
+  Stats Delta() const;
+
+ private:
+  const char *name_;
+  Stats start_;
+  int64_t outer_peak_;
+};
+
+}  // namespace alloc_tracker
@@ -0,0 +1,160 @@
+/**
+ * @file alloc_tracking.cpp
+ * @brief Tutorial code on counting the heap allocations of STL containers and
+ * smart pointers with the allocation tracker.
+ */
+
+// Most of the cost of a container operation that allocates is the allocation
+// itself. Profilers show where time goes, but they do not answer the simpler
+// question of how many times an operation calls operator new. This file links
+// in the allocation tracker (src/alloc_tracker), which counts every call, and
+// uses ScopedRegion to measure the containers and pointers from vectors.cpp,
+// unordered_maps.cpp, shared_ptr.cpp and iterator.cpp.
+
+// The last section shows how to use it against regressions: measure a hot
+// path, and fail loudly when it starts allocating more than it should.
+
+// Includes the allocation tracker.
+#include "alloc_tracker/alloc_tracker.h"
+
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::shared_ptr and std::make_shared.
+#include <memory>
+// Includes std::string.
+#include <string>
+// Includes the unordered_map container library header.
+#include <unordered_map>
+// Includes the vector container library header.
+#include <vector>
+
+// The DLL node from iterator.cpp. One node is one allocation.
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  Node *next_;
+  Node *prev_;
+  int value_;
+};
+
+// The Point class from shared_ptr.cpp.
+class Point {
+ public:
+  Point() : x_(0), y_(0) {}
+  Point(int x, int y) : x_(x), y_(y) {}
+
+ private:
+  int x_;
+  int y_;
+};
+
+// Prints the allocations per operation of a region that ran ops operations.
+void Report(const std::string &what, const alloc_tracker::Stats &delta, size_t ops) {
+  std::cout << what << ": " << static_cast<double>(delta.allocations_) / static_cast<double>(ops)
+            << " allocations/op, " << static_cast<double>(delta.bytes_allocated_) / static_cast<double>(ops)
+            << " bytes/op, peak live " << delta.peak_live_bytes_ << " bytes\n";
+}
+
+int main() {
+  const size_t ops = 100000;
+
+  {
+    alloc_tracker::ScopedRegion region;
+    std::vector<int> vec;
+    for (size_t i = 0; i < ops; i++) {
+      vec.push_back(static_cast<int>(i));
+    }
+    Report("vector push_back", region.Delta(), ops);
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    std::vector<int> vec;
+    vec.reserve(ops);
+    for (size_t i = 0; i < ops; i++) {
+      vec.push_back(static_cast<int>(i));
+    }
+    Report("vector push_back after reserve", region.Delta(), ops);
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    std::unordered_map<int, int> map;
+    for (size_t i = 0; i < ops; i++) {
+      map.emplace(static_cast<int>(i), static_cast<int>(i));
+    }
+    Report("unordered_map emplace", region.Delta(), ops);
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    std::unordered_map<int, int> map;
+    map.reserve(ops);
+    for (size_t i = 0; i < ops; i++) {
+      map.emplace(static_cast<int>(i), static_cast<int>(i));
+    }
+    Report("unordered_map emplace after reserve", region.Delta(), ops);
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    for (size_t i = 0; i < ops; i++) {
+      std::shared_ptr<Point> ptr(new Point(1, 2));
+    }
+    Report("shared_ptr<Point>(new Point)", region.Delta(), ops);
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    for (size_t i = 0; i < ops; i++) {
+      auto ptr = std::make_shared<Point>(1, 2);
+    }
+    Report("make_shared<Point>", region.Delta(), ops);
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    Node *head = nullptr;
+    for (size_t i = 0; i < ops; i++) {
+      Node *node = new Node(static_cast<int>(i));
+      node->next_ = head;
+      head = node;
+    }
+    while (head != nullptr) {
+      Node *next = head->next_;
+      delete head;
+      head = next;
+    }
+    Report("DLL InsertAtHead", region.Delta(), ops);
+  }
+
+  // Where the bytes go: the size-class histogram of an unordered_map<int,
+  // std::string> with short and long strings. Short strings fit in the
+  // std::string object itself and allocate nothing.
+  {
+    alloc_tracker::ScopedRegion region;
+    std::unordered_map<int, std::string> map;
+    for (int i = 0; i < 1000; i++) {
+      map.emplace(i, std::string(i % 2 == 0 ? 8 : 100, 'x'));
+    }
+    alloc_tracker::Stats delta = region.Delta();
+    std::cout << "\nSize classes of 1000 unordered_map<int, std::string> inserts:\n";
+    for (size_t i = 0; i < alloc_tracker::kSizeClasses; i++) {
+      if (delta.size_classes_[i] != 0) {
+        std::cout << "  <= " << alloc_tracker::SizeClassLimit(i) << " bytes: " << delta.size_classes_[i] << "\n";
+      }
+    }
+  }
+
+  // Guarding a hot path: once reserved, this loop must not allocate. A named
+  // region also prints its own report to std::cerr.
+  std::vector<int> scratch;
+  scratch.reserve(ops);
+  {
+    alloc_tracker::ScopedRegion region("hot loop");
+    for (size_t i = 0; i < ops; i++) {
+      scratch.push_back(static_cast<int>(i));
+    }
+    if (region.Delta().allocations_ != 0) {
+      std::cout << "Regression: the hot loop allocated " << region.Delta().allocations_ << " times\n";
+      return 1;
+    }
+  }
+  std::cout << "\nThe hot loop made no allocations\n";
+
+  return 0;
+}
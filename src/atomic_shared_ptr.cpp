@@ -0,0 +1,403 @@
+/**
+ * @file atomic_shared_ptr.cpp
+ * @brief Tutorial code on a lock-free atomic shared pointer, for publishing
+ * immutable snapshots from one writer to many readers.
+ */
+
+// A common way to share read-mostly data, such as a configuration, is to
+// never modify it. The writer builds a new immutable snapshot, publishes a
+// shared pointer to it, and readers grab the current pointer whenever they
+// need it. An old snapshot is freed once the last reader lets go of it.
+
+// Copying a std::shared_ptr (see shared_ptr.cpp) is thread safe, but reading
+// and replacing the same shared_ptr variable from several threads is not: a
+// reader could load the control block pointer just before the writer drops
+// the last reference and frees it. C++20 has std::atomic<std::shared_ptr<T>>
+// for this, but in C++17 the usual answer is a mutex around the variable, so
+// every reader briefly blocks the writer and every other reader.
+
+// AtomicSharedPtr below is lock-free, using a split reference count. Every
+// store() wraps the SharedPtr it publishes in a small Publication node, and
+// the count of readers using a publication lives in two places:
+//   - a "local" count of readers that are in the middle of load(). It sits
+//     in the top 16 bits of the same 64-bit word as the Publication pointer.
+//     x86-64 and AArch64 user space pointers fit in the other 48 bits.
+//   - the "external" count in the Publication itself.
+// load() bumps the local count and reads the pointer in one atomic
+// fetch_add. The reader now holds a claim on the publication, so it cannot
+// be freed under it, and copies the publication's SharedPtr, which takes a
+// proper reference on the snapshot. Then it gives its claim back: by
+// decrementing the local count if the word still holds its publication, or
+// else by decrementing the external count. When store() swaps in a new
+// publication, it adds the old word's local count to the old publication's
+// external count, so the external count reaches zero exactly when the last
+// claim is given back, and the publication is freed then.
+
+// Comparing Publication pointers rather than snapshot pointers is what makes
+// this safe when the same snapshot is published again, as in store(a),
+// store(b), store(a). Every store() has its own Publication, and its address
+// cannot be reused while a reader still holds a claim on it, so a reader that
+// finds its publication in the word knows its claim is in that word's local
+// count.
+
+// Lock-free does not mean scalable. Every load() does two atomic
+// read-modify-writes on the one shared word: the fetch_add that claims the
+// publication, and the compare-exchange that gives the claim back. Each of
+// them needs the word's cache line exclusively, so concurrent readers take
+// turns on it, and read throughput does not grow with the number of cores.
+// Copying the SharedPtr adds a third one, on the snapshot's shared count.
+// AtomicSharedPtr beats the mutex only because it never blocks, not because
+// readers run in parallel. To scale, readers must stop writing shared memory,
+// for example with the per-reader epoch slots of epoch_dll.cpp.
+
+// Includes std::atomic.
+#include <atomic>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::shared_ptr, used by the baseline.
+#include <memory>
+// Includes the mutex library header, used by the baseline.
+#include <mutex>
+// Includes std::runtime_error.
+#include <stdexcept>
+// Includes the thread library header.
+#include <thread>
+// Includes std::forward.
+#include <utility>
+// Includes the vector container library header.
+#include <vector>
+
+template <typename T>
+class AtomicSharedPtr;
+
+// The object and its global reference count, allocated together like
+// std::make_shared does.
+template <typename T>
+struct ControlBlock {
+  template <typename... Args>
+  explicit ControlBlock(Args &&...args) : count_(1), value_(std::forward<Args>(args)...) {}
+
+  std::atomic<int64_t> count_;
+  T value_;
+};
+
+// A minimal std::shared_ptr, whose control block AtomicSharedPtr can reach
+// into.
+template <typename T>
+class SharedPtr {
+ public:
+  SharedPtr() : block_(nullptr) {}
+
+  ~SharedPtr() { Reset(); }
+
+  SharedPtr(const SharedPtr &other) : block_(other.block_) {
+    if (block_ != nullptr) {
+      block_->count_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  SharedPtr(SharedPtr &&other) noexcept : block_(other.block_) { other.block_ = nullptr; }
+
+  SharedPtr &operator=(SharedPtr other) noexcept {
+    std::swap(block_, other.block_);
+    return *this;
+  }
+
+  void Reset() {
+    if (block_ != nullptr && block_->count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete block_;
+    }
+    block_ = nullptr;
+  }
+
+  const T *Get() const { return block_ != nullptr ? &block_->value_ : nullptr; }
+  const T &operator*() const { return block_->value_; }
+  const T *operator->() const { return &block_->value_; }
+  explicit operator bool() const { return block_ != nullptr; }
+
+  int64_t UseCount() const { return block_ != nullptr ? block_->count_.load(std::memory_order_relaxed) : 0; }
+
+  template <typename U, typename... Args>
+  friend SharedPtr<U> MakeShared(Args &&...args);
+
+ private:
+  friend class AtomicSharedPtr<T>;
+
+  // Adopts a reference the caller already owns.
+  explicit SharedPtr(ControlBlock<T> *block) : block_(block) {}
+
+  ControlBlock<T> *block_;
+};
+
+template <typename T, typename... Args>
+SharedPtr<T> MakeShared(Args &&...args) {
+  return SharedPtr<T>(new ControlBlock<T>(std::forward<Args>(args)...));
+}
+
+template <typename T>
+class AtomicSharedPtr {
+ public:
+  AtomicSharedPtr() : packed_(Publish(SharedPtr<T>())) {}
+
+  explicit AtomicSharedPtr(SharedPtr<T> desired) : packed_(Publish(std::move(desired))) {}
+
+  // Must only run once no other thread uses this AtomicSharedPtr.
+  ~AtomicSharedPtr() { Retire(packed_.load(std::memory_order_acquire)); }
+
+  AtomicSharedPtr(const AtomicSharedPtr &) = delete;
+  AtomicSharedPtr &operator=(const AtomicSharedPtr &) = delete;
+
+  SharedPtr<T> load() const {
+    // Take a claim and read the pointer in one step.
+    Publication *publication = PublicationOf(packed_.fetch_add(kOneLocal, std::memory_order_acquire));
+    SharedPtr<T> result = publication->ptr_;
+    GiveBack(publication);
+    return result;
+  }
+
+  void store(SharedPtr<T> desired) {
+    Retire(packed_.exchange(Publish(std::move(desired)), std::memory_order_acq_rel));
+  }
+
+  // Replaces the pointer with desired if it still points at the same object as
+  // expected, and returns true. Otherwise loads the current pointer into
+  // expected and returns false.
+  bool compare_exchange_strong(SharedPtr<T> &expected, SharedPtr<T> desired) {
+    uint64_t replacement = Publish(std::move(desired));
+    while (true) {
+      // Claim the current publication, so that it stays alive while we look
+      // at its SharedPtr.
+      uint64_t current = packed_.fetch_add(kOneLocal, std::memory_order_acquire) + kOneLocal;
+      Publication *seen = PublicationOf(current);
+      if (seen->ptr_.block_ != expected.block_) {
+        expected = seen->ptr_;
+        GiveBack(seen);
+        Retire(replacement);
+        return false;
+      }
+      // The CAS fails, and is retried, if a reader changed the local count.
+      while (PublicationOf(current) == seen) {
+        if (packed_.compare_exchange_weak(current, replacement, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed)) {
+          // Our own claim is part of the local count that Retire credits, so
+          // the publication outlives Retire, and GiveBack then drops the claim.
+          Retire(current);
+          GiveBack(seen);
+          return true;
+        }
+      }
+      // Another store() got in first, maybe publishing expected's object
+      // again. Look again.
+      GiveBack(seen);
+    }
+  }
+
+  static constexpr bool is_always_lock_free = std::atomic<uint64_t>::is_always_lock_free;
+
+ private:
+  static constexpr uint64_t kPointerMask = (uint64_t{1} << 48) - 1;
+  static constexpr uint64_t kOneLocal = uint64_t{1} << 48;
+
+  // One store() of a SharedPtr. external_ counts claims given back after
+  // the publication was replaced, minus the local count credited to it then.
+  struct Publication {
+    explicit Publication(SharedPtr<T> ptr) : ptr_(std::move(ptr)), external_(0) {}
+
+    SharedPtr<T> ptr_;
+    std::atomic<int64_t> external_;
+  };
+
+  // Wraps ptr in a new Publication, and returns it packed with a local count
+  // of zero.
+  static uint64_t Publish(SharedPtr<T> ptr) {
+    auto *publication = new Publication(std::move(ptr));
+    auto packed = reinterpret_cast<uintptr_t>(publication);
+    if ((packed & ~kPointerMask) != 0) {
+      delete publication;
+      throw std::runtime_error("pointer does not fit in 48 bits");
+    }
+    return packed;
+  }
+
+  static Publication *PublicationOf(uint64_t packed) {
+    return reinterpret_cast<Publication *>(static_cast<uintptr_t>(packed & kPointerMask));
+  }
+
+  // Gives back a claim on publication: through the local count while
+  // packed_ still holds publication, or else through its external count.
+  void GiveBack(Publication *publication) const {
+    uint64_t current = packed_.load(std::memory_order_relaxed);
+    while (PublicationOf(current) == publication) {
+      if (packed_.compare_exchange_weak(current, current - kOneLocal, std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    if (publication->external_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete publication;
+    }
+  }
+
+  // Called with a packed value that packed_ no longer holds. Credits its local
+  // count of claims to the publication's external count, and frees the
+  // publication if all of those claims were already given back.
+  static void Retire(uint64_t packed) {
+    Publication *publication = PublicationOf(packed);
+    auto local = static_cast<int64_t>(packed >> 48);
+    if (publication->external_.fetch_add(local, std::memory_order_acq_rel) + local == 0) {
+      delete publication;
+    }
+  }
+
+  mutable std::atomic<uint64_t> packed_;
+};
+
+static_assert(AtomicSharedPtr<int>::is_always_lock_free, "AtomicSharedPtr needs a lock-free 64-bit atomic");
+
+// The baseline: a std::shared_ptr behind a mutex.
+template <typename T>
+class MutexSharedPtr {
+ public:
+  std::shared_ptr<const T> load() const {
+    std::scoped_lock lock(m_);
+    return ptr_;
+  }
+
+  void store(std::shared_ptr<const T> desired) {
+    std::scoped_lock lock(m_);
+    ptr_.swap(desired);
+    // The old snapshot, now in desired, is released after the lock is dropped.
+  }
+
+ private:
+  mutable std::mutex m_;
+  std::shared_ptr<const T> ptr_;
+};
+
+// A configuration snapshot. Every field holds the version, so a reader can
+// check that it never sees a half-built or freed snapshot.
+struct Config {
+  explicit Config(int version) : version_(version) {
+    for (int &value : values_) {
+      value = version;
+    }
+  }
+
+  int version_;
+  int values_[15];
+};
+
+SharedPtr<Config> MakeConfig(int version) { return MakeShared<Config>(version); }
+std::shared_ptr<const Config> MakeStdConfig(int version) { return std::make_shared<const Config>(version); }
+
+// Runs readers that load the current snapshot and check it, while one writer
+// publishes a new snapshot every 50 microseconds. Returns loads per second.
+template <typename Published, typename Make>
+double ReadThroughput(size_t readers, std::chrono::milliseconds duration, Make make) {
+  Published published;
+  published.store(make(0));
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> total_loads{0};
+  std::atomic<size_t> torn{0};
+
+  std::thread writer([&] {
+    int version = 1;
+    while (!stop.load(std::memory_order_relaxed)) {
+      published.store(make(version++));
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  });
+  std::vector<std::thread> threads;
+  for (size_t r = 0; r < readers; r++) {
+    threads.emplace_back([&] {
+      size_t loads = 0;
+      size_t bad = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto config = published.load();
+        bad += config->values_[14] != config->version_ ? 1 : 0;
+        loads += 1;
+      }
+      total_loads.fetch_add(loads, std::memory_order_relaxed);
+      torn.fetch_add(bad, std::memory_order_relaxed);
+    });
+  }
+
+  std::this_thread::sleep_for(duration);
+  stop.store(true, std::memory_order_relaxed);
+  writer.join();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  if (torn.load() != 0) {
+    std::cout << "Readers saw " << torn.load() << " inconsistent snapshots!\n";
+  }
+  return static_cast<double>(total_loads.load()) / std::chrono::duration<double>(duration).count();
+}
+
+// Publishes the same two snapshots in turn, store(b), store(a), store(b), ...,
+// while readers load. A reader that gave its claim back to the wrong
+// publication would leave the use counts off, and the snapshots leaked or
+// freed too early. Returns true if the counts come out right.
+bool RepublishKeepsCounts(size_t readers, int stores) {
+  SharedPtr<Config> a = MakeConfig(1);
+  SharedPtr<Config> b = MakeConfig(2);
+  {
+    AtomicSharedPtr<Config> published(a);
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; r++) {
+      threads.emplace_back([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+          SharedPtr<Config> config = published.load();
+        }
+      });
+    }
+    for (int i = 0; i < stores; i++) {
+      published.store(i % 2 == 0 ? b : a);
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+  return a.UseCount() == 1 && b.UseCount() == 1;
+}
+
+int main() {
+  AtomicSharedPtr<Config> current(MakeConfig(1));
+  SharedPtr<Config> seen = current.load();
+  std::cout << "Loaded version " << seen->version_ << ", use count " << seen.UseCount() << "\n";
+
+  // A writer that only publishes if nobody else published since it looked.
+  SharedPtr<Config> expected = seen;
+  bool swapped = current.compare_exchange_strong(expected, MakeConfig(2));
+  std::cout << "compare_exchange from version 1: " << (swapped ? "swapped" : "failed") << ", now version "
+            << current.load()->version_ << "\n";
+  swapped = current.compare_exchange_strong(expected, MakeConfig(3));
+  std::cout << "compare_exchange from stale version 1: " << (swapped ? "swapped" : "failed")
+            << ", expected now holds version " << expected->version_ << "\n";
+  // The reader's old snapshot is still alive, and now it is the only owner.
+  std::cout << "Old snapshot: version " << seen->version_ << ", use count " << seen.UseCount() << "\n\n";
+
+  bool counts_ok = RepublishKeepsCounts(4, 2000000);
+  std::cout << "Use counts after 2M alternating stores of the same two snapshots: " << (counts_ok ? "correct" : "WRONG")
+            << "\n\n";
+  if (!counts_ok) {
+    return 1;
+  }
+
+  const auto duration = std::chrono::milliseconds(300);
+  std::cout << "Loads/s while a writer publishes every 50 us (this machine has "
+            << std::thread::hardware_concurrency() << " hardware threads)\n";
+  for (size_t readers : {1, 2, 4, 8, 16}) {
+    double locked = ReadThroughput<MutexSharedPtr<Config>>(readers, duration, MakeStdConfig);
+    double lock_free = ReadThroughput<AtomicSharedPtr<Config>>(readers, duration, MakeConfig);
+    std::cout << readers << " reader(s): mutex " << locked << ", AtomicSharedPtr " << lock_free << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file compact_dll.cpp
+ * @brief Tutorial code on a doubly linked list whose nodes link to each other
+ * with 32-bit indices instead of pointers.
+ */
+
+// A Node in iterator.cpp is two 8-byte pointers next to a 4-byte int. With
+// padding that is 24 bytes per node, of which 20 are links and padding.
+
+// In this file, every node of a list lives in one std::vector, and nodes refer
+// to each other by their uint32_t index in that vector. A node shrinks to 12
+// bytes, all nodes of a list are contiguous, and since nothing in the list
+// stores an address, the whole list can be copied, moved, or written to disk
+// and read back as a plain block of bytes. The price is a limit of 2^32 - 1
+// nodes per list.
+
+// The iterator keeps the interface of the one in range_based_for.cpp, so
+// range-based for loops work unchanged.
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::strtoull for parsing the element count.
+#include <cstdlib>
+// Includes std::memcpy, used for serialization.
+#include <cstring>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::length_error and std::invalid_argument.
+#include <stdexcept>
+// Includes std::is_trivially_copyable.
+#include <type_traits>
+// Includes the vector container library header.
+#include <vector>
+
+// The index used to mean "no node", like nullptr for pointer links.
+constexpr uint32_t kNil = UINT32_MAX;
+
+// This is the definition of the Node struct, used in our CompactDLL.
+struct Node {
+  uint32_t next_;
+  uint32_t prev_;
+  int value_;
+};
+
+static_assert(sizeof(Node) == 12, "a compact node is three 4-byte fields");
+// Copying the node array byte for byte is only correct for trivially copyable
+// nodes.
+static_assert(std::is_trivially_copyable<Node>::value, "nodes are serialized with memcpy");
+
+class CompactDLL {
+ public:
+  CompactDLL() : head_(kNil) {}
+
+  // The iterator holds the node array and an index into it.
+  class DLLIterator {
+   public:
+    DLLIterator(const Node *nodes, uint32_t curr) : nodes_(nodes), curr_(curr) {}
+
+    DLLIterator &operator++() {
+      curr_ = nodes_[curr_].next_;
+      return *this;
+    }
+
+    bool operator!=(const DLLIterator &itr) const { return itr.curr_ != this->curr_; }
+
+    int operator*() { return nodes_[curr_].value_; }
+
+   private:
+    const Node *nodes_;
+    uint32_t curr_;
+  };
+
+  DLLIterator begin() { return DLLIterator(nodes_.data(), head_); }
+
+  DLLIterator end() { return DLLIterator(nodes_.data(), kNil); }
+
+  // Function for inserting val at the head of the list. The list may hold at
+  // most kNil - 1 nodes.
+  void InsertAtHead(int val) {
+    if (nodes_.size() >= kNil - 1) {
+      throw std::length_error("CompactDLL is full");
+    }
+    auto new_node = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back(Node{head_, kNil, val});
+
+    if (head_ != kNil) {
+      nodes_[head_].prev_ = new_node;
+    }
+
+    head_ = new_node;
+  }
+
+  size_t Size() const { return nodes_.size(); }
+
+  // The number of bytes taken by the nodes of this list.
+  size_t NodeBytes() const { return nodes_.size() * sizeof(Node); }
+
+  // Serializes the list into a flat buffer: the head index, followed by the
+  // node array exactly as it is laid out in memory.
+  std::vector<char> Serialize() const {
+    std::vector<char> bytes(sizeof(head_) + NodeBytes());
+    std::memcpy(bytes.data(), &head_, sizeof(head_));
+    std::memcpy(bytes.data() + sizeof(head_), nodes_.data(), NodeBytes());
+    return bytes;
+  }
+
+  // Rebuilds a list from a buffer made by Serialize(). There is no pointer to
+  // fix up, so this is just a copy, followed by a check that the links form
+  // one well-formed list.
+  static CompactDLL Deserialize(const std::vector<char> &bytes) {
+    if (bytes.size() < sizeof(uint32_t) || (bytes.size() - sizeof(uint32_t)) % sizeof(Node) != 0 ||
+        (bytes.size() - sizeof(uint32_t)) / sizeof(Node) >= kNil) {
+      throw std::invalid_argument("not a serialized CompactDLL");
+    }
+    CompactDLL list;
+    std::memcpy(&list.head_, bytes.data(), sizeof(list.head_));
+    list.nodes_.resize((bytes.size() - sizeof(list.head_)) / sizeof(Node));
+    std::memcpy(list.nodes_.data(), bytes.data() + sizeof(list.head_), list.NodeBytes());
+    if (!list.LinksAreValid()) {
+      throw std::invalid_argument("not a serialized CompactDLL");
+    }
+    return list;
+  }
+
+ private:
+  // Walks the list from head_ and returns true if every link is in range, every
+  // node's prev_ points back at the node before it, and the walk ends at kNil
+  // after visiting every node exactly once. Nodes are never removed, so a list
+  // made by InsertAtHead always links all of its nodes. Iterating over a list
+  // that passes can neither leave the node array nor loop forever.
+  bool LinksAreValid() const {
+    uint32_t prev = kNil;
+    uint32_t curr = head_;
+    size_t visited = 0;
+    while (curr != kNil) {
+      if (curr >= nodes_.size() || visited == nodes_.size() || nodes_[curr].prev_ != prev) {
+        return false;
+      }
+      prev = curr;
+      curr = nodes_[curr].next_;
+      visited += 1;
+    }
+    return visited == nodes_.size();
+  }
+
+  uint32_t head_;
+  std::vector<Node> nodes_;
+};
+
+// The pointer-linked node from iterator.cpp, used for comparison.
+struct PointerNode {
+  PointerNode *next_;
+  PointerNode *prev_;
+  int value_;
+};
+
+int main(int argc, char *argv[]) {
+  CompactDLL dll;
+  dll.InsertAtHead(6);
+  dll.InsertAtHead(5);
+  dll.InsertAtHead(4);
+  dll.InsertAtHead(3);
+  dll.InsertAtHead(2);
+  dll.InsertAtHead(1);
+
+  std::cout << "Using range-based for statement\n";
+  for (const auto &item : dll) {
+    std::cout << item << " ";
+  }
+  std::cout << std::endl;
+
+  // Because the links are indices, the implicitly generated copy constructor
+  // already produces a correct, independent list. Copying a pointer-linked
+  // list this way would make both lists share the same nodes.
+  CompactDLL copy = dll;
+  copy.InsertAtHead(0);
+  std::cout << "Copy with an extra element\n";
+  for (const auto &item : copy) {
+    std::cout << item << " ";
+  }
+  std::cout << std::endl;
+
+  // Round trip through a flat byte buffer, as we would through a file.
+  CompactDLL restored = CompactDLL::Deserialize(dll.Serialize());
+  std::cout << "Restored from " << dll.Serialize().size() << " bytes\n";
+  for (const auto &item : restored) {
+    std::cout << item << " ";
+  }
+  std::cout << "\n\n";
+
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  CompactDLL big;
+  for (size_t i = 0; i < count; i++) {
+    big.InsertAtHead(static_cast<int>(i));
+  }
+  auto start = std::chrono::steady_clock::now();
+  long long sum = 0;
+  for (int item : big) {
+    sum += item;
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+  std::cout << "sizeof(Node) = " << sizeof(Node) << ", sizeof(PointerNode) = " << sizeof(PointerNode) << "\n";
+  std::cout << count << " elements: " << big.NodeBytes() << " bytes of nodes (pointer-linked: "
+            << count * sizeof(PointerNode) << " bytes plus one malloc header per node)\n";
+  std::cout << "scan: sum " << sum << ", " << ns / static_cast<double>(count) << " ns/element\n";
+
+  return 0;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file concurrent_dll.cpp
+ * @brief Tutorial code on a lock-free, concurrent InsertAtHead for a doubly
+ * linked list.
+ */
+
+// InsertAtHead in iterator.cpp updates head_, the old head's prev_ and size_
+// as three separate, non-atomic steps. If two threads run it at the same time,
+// both can read the same head_ and one of the two new nodes is lost. The simple
+// fix is a std::mutex around the whole list (see mutex.cpp), but then every
+// producer waits for every other producer.
+
+// This file makes InsertAtHead lock-free instead:
+//   1. head_ is a std::atomic<Node *>. A producer prepares its node with
+//      next_ = the head it saw, and publishes it with compare_exchange. If
+//      another producer got there first, the CAS fails, reloads the head, and
+//      the producer simply retries.
+//   2. size_ is split into per-thread stripes that sit on different cache
+//      lines, so producers never fight over one counter. Size() sums them.
+//   3. The list is insert-only, so a node is never unlinked while the list is
+//      alive. A reader that loaded a node pointer can therefore never touch
+//      freed memory, which is the whole safe-memory-reclamation problem for
+//      this API. Nodes are only freed by the destructor, which (as with every
+//      C++ object) must not race with any other use of the list. Lists that
+//      also remove nodes need a real reclamation scheme, such as the epochs
+//      in epoch_dll.cpp or hazard pointers.
+
+// Includes std::array, used for the size stripes.
+#include <array>
+// Includes std::atomic.
+#include <atomic>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::strtoull for parsing the element count.
+#include <cstdlib>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes the mutex library header, used by the baseline.
+#include <mutex>
+// Includes the thread library header.
+#include <thread>
+// Includes the vector container library header.
+#include <vector>
+
+constexpr size_t kCacheLineSize = 64;
+
+// next_ is written once, before the node is published, and never changes
+// afterwards, so readers can use a plain load. prev_ is written by whichever
+// producer pushes the next node on top of this one, possibly while a reader
+// looks at it, so it is atomic.
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  Node *next_;
+  std::atomic<Node *> prev_;
+  int value_;
+};
+
+// A size counter split into stripes. Each thread always adds to the same
+// stripe, and stripes live on separate cache lines.
+class StripedCounter {
+ public:
+  static constexpr size_t kStripes = 32;
+
+  StripedCounter() {
+    for (Stripe &stripe : stripes_) {
+      stripe.count_.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void Increment() { stripes_[MyStripe()].count_.fetch_add(1, std::memory_order_relaxed); }
+
+  // The sum is exact once all producers are done. While they are running it
+  // is a value the counter had at some point during the call.
+  size_t Sum() const {
+    size_t sum = 0;
+    for (const Stripe &stripe : stripes_) {
+      sum += stripe.count_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(kCacheLineSize) Stripe {
+    std::atomic<size_t> count_;
+  };
+
+  // Threads are handed stripes round robin, the first time they increment.
+  static size_t MyStripe() {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    return stripe;
+  }
+
+  std::array<Stripe, kStripes> stripes_;
+};
+
+// The same iterator as in iterator.cpp. It is safe to use while producers are
+// inserting; it sees the list as it was when Begin() loaded the head.
+class DLLIterator {
+ public:
+  DLLIterator(Node *head) : curr_(head) {}
+
+  DLLIterator &operator++() {
+    curr_ = curr_->next_;
+    return *this;
+  }
+
+  bool operator==(const DLLIterator &itr) const { return itr.curr_ == curr_; }
+
+  bool operator!=(const DLLIterator &itr) const { return itr.curr_ != curr_; }
+
+  int operator*() { return curr_->value_; }
+
+ private:
+  Node *curr_;
+};
+
+// A DLL whose InsertAtHead can be called from many threads at once.
+class ConcurrentDLL {
+ public:
+  ConcurrentDLL() : head_(nullptr) {}
+
+  // Must only run once every producer and reader is done with the list.
+  ~ConcurrentDLL() {
+    Node *current = head_.load(std::memory_order_acquire);
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+  }
+
+  ConcurrentDLL(const ConcurrentDLL &) = delete;
+  ConcurrentDLL &operator=(const ConcurrentDLL &) = delete;
+
+  // Lock-free insert at the head of the list.
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    Node *old_head = head_.load(std::memory_order_relaxed);
+    do {
+      new_node->next_ = old_head;
+      // On failure, compare_exchange_weak stores the current head into
+      // old_head, so the loop just relinks and tries again. On success, the
+      // release ordering makes new_node's fields visible to any thread that
+      // loads it from head_ with acquire ordering.
+    } while (!head_.compare_exchange_weak(old_head, new_node, std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the producer whose CAS replaced old_head can get here with that
+    // old_head, so prev_ is written exactly once per node.
+    if (old_head != nullptr) {
+      old_head->prev_.store(new_node, std::memory_order_release);
+    }
+    size_.Increment();
+  }
+
+  DLLIterator Begin() { return DLLIterator(head_.load(std::memory_order_acquire)); }
+
+  DLLIterator End() { return DLLIterator(nullptr); }
+
+  size_t Size() const { return size_.Sum(); }
+
+ private:
+  std::atomic<Node *> head_;
+  StripedCounter size_;
+};
+
+// The baseline: the DLL from iterator.cpp, with one mutex around it.
+class LockedDLL {
+ public:
+  LockedDLL() : head_(nullptr), size_(0) {}
+
+  ~LockedDLL() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+  }
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    std::scoped_lock lock(m_);
+    new_node->next_ = head_;
+    if (head_ != nullptr) {
+      head_->prev_.store(new_node, std::memory_order_relaxed);
+    }
+    head_ = new_node;
+    size_ += 1;
+  }
+
+  size_t Size() {
+    std::scoped_lock lock(m_);
+    return size_;
+  }
+
+ private:
+  std::mutex m_;
+  Node *head_;
+  size_t size_;
+};
+
+// Inserts total elements with the given number of producer threads, and
+// returns the throughput in millions of inserts per second.
+template <typename List>
+double InsertThroughput(size_t total, size_t threads) {
+  List list;
+  std::vector<std::thread> producers;
+  size_t per_thread = total / threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < threads; t++) {
+    producers.emplace_back([&list, per_thread, t] {
+      for (size_t i = 0; i < per_thread; i++) {
+        list.InsertAtHead(static_cast<int>(t * per_thread + i));
+      }
+    });
+  }
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (list.Size() != per_thread * threads) {
+    std::cout << "Lost inserts: expected " << per_thread * threads << ", found " << list.Size() << "\n";
+  }
+  double seconds = std::chrono::duration<double>(end - start).count();
+  return static_cast<double>(per_thread * threads) / seconds / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+  // Four producers fill the list at the same time; no element is lost.
+  ConcurrentDLL dll;
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; t++) {
+    producers.emplace_back([&dll, t] {
+      for (int i = 0; i < 5; i++) {
+        dll.InsertAtHead(t * 10 + i);
+      }
+    });
+  }
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+  std::cout << "Elements inserted by 4 producers (" << dll.Size() << " in total)\n";
+  for (DLLIterator iter = dll.Begin(); iter != dll.End(); ++iter) {
+    std::cout << *iter << " ";
+  }
+  std::cout << "\n\n";
+
+  size_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+  std::cout << "Mops/s for " << total << " inserts (this machine has " << std::thread::hardware_concurrency()
+            << " hardware threads)\n";
+  for (size_t threads : {1, 2, 4, 8, 16}) {
+    double locked = InsertThroughput<LockedDLL>(total, threads);
+    double lock_free = InsertThroughput<ConcurrentDLL>(total, threads);
+    std::cout << threads << " producer(s): mutex " << locked << ", lock-free " << lock_free << "\n";
+  }
+
+  return 0;
+}
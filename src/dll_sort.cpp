@@ -0,0 +1,306 @@
+/**
+ * @file dll_sort.cpp
+ * @brief Tutorial code on sorting and merging doubly linked lists in place.
+ */
+
+// The easy way to sort the DLL from iterator.cpp is to copy its values into a
+// std::vector, std::sort the vector, and build a new list from it. That needs
+// a second copy of the data and a fresh allocation for every node.
+
+// A linked list can be sorted without any of that: merge sort only ever needs
+// to look at the front of two runs, and "moving" a node into the merged run is
+// just relinking it. The bottom-up version below builds sorted runs of 1, 2,
+// 4, ... nodes in place. It does not recurse, allocates nothing, and its only
+// extra space is a fixed array of 64 run heads. It is also stable: equal
+// values keep their relative order.
+
+// MergeSorted uses the same merge step to splice a second sorted list into
+// this one, again without allocating.
+
+// Includes std::sort for the baseline.
+#include <algorithm>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::strtoull for parsing the element count.
+#include <cstdlib>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::mt19937 for random values.
+#include <random>
+// Includes std::move.
+#include <utility>
+// Includes the vector container library header, used by the baseline.
+#include <vector>
+
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  Node *next_;
+  Node *prev_;
+  int value_;
+};
+
+class DLLIterator {
+ public:
+  DLLIterator(Node *head) : curr_(head) {}
+
+  DLLIterator &operator++() {
+    curr_ = curr_->next_;
+    return *this;
+  }
+
+  bool operator==(const DLLIterator &itr) const { return itr.curr_ == curr_; }
+
+  bool operator!=(const DLLIterator &itr) const { return itr.curr_ != curr_; }
+
+  int operator*() { return curr_->value_; }
+
+ private:
+  Node *curr_;
+};
+
+class DLL {
+ public:
+  DLL() : head_(nullptr), size_(0) {}
+
+  ~DLL() { Clear(); }
+
+  DLL(const DLL &) = delete;
+  DLL &operator=(const DLL &) = delete;
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    new_node->next_ = head_;
+
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    }
+
+    head_ = new_node;
+    size_ += 1;
+  }
+
+  // Deletes every node.
+  void Clear() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+    head_ = nullptr;
+    size_ = 0;
+  }
+
+  // Sorts the list in ascending order by relinking its nodes. Runs in
+  // O(n log n) time, is stable, and needs only a fixed array of 64 run heads
+  // no matter how long the list is.
+  void Sort() {
+    // runs[i] is either empty or a sorted run of 2^i nodes. Nodes are taken
+    // off the list one by one and carried up through the array like a binary
+    // counter, merging equal-sized runs as they meet. Compared with merging
+    // runs of width 1, 2, 4, ... across the whole list, this keeps the small
+    // merges on recently touched (and so cached) nodes.
+    Node *runs[64] = {};
+    Node *rest = head_;
+    while (rest != nullptr) {
+      Node *carry = rest;
+      rest = rest->next_;
+      carry->next_ = nullptr;
+      size_t i = 0;
+      for (; runs[i] != nullptr; i++) {
+        // runs[i] holds nodes that came earlier in the list, so it goes
+        // first to keep the sort stable.
+        carry = MergeRuns(runs[i], carry);
+        runs[i] = nullptr;
+      }
+      runs[i] = carry;
+    }
+
+    Node *sorted = nullptr;
+    for (Node *run : runs) {
+      if (run != nullptr) {
+        sorted = MergeRuns(run, sorted);
+      }
+    }
+    head_ = sorted;
+    FixPrevLinks();
+  }
+
+  // Merges other into this list. Both lists must already be sorted; the
+  // result is sorted, and other is left empty. No node is allocated or
+  // copied. For equal values, the nodes of this list come first. Merging a
+  // list into itself does nothing.
+  void MergeSorted(DLL &&other) {
+    if (&other == this) {
+      return;
+    }
+    head_ = MergeRuns(head_, other.head_);
+    FixPrevLinks();
+    size_ += other.size_;
+    other.head_ = nullptr;
+    other.size_ = 0;
+  }
+
+  DLLIterator Begin() { return DLLIterator(head_); }
+
+  DLLIterator End() { return DLLIterator(nullptr); }
+
+  size_t Size() const { return size_; }
+
+ private:
+  // Merges the sorted, nullptr-terminated runs a and b through their next_
+  // links only, and returns the head of the merged run. On ties, a goes
+  // first.
+  static Node *MergeRuns(Node *a, Node *b) {
+    // A node on the stack stands in front of the merged run, so that the
+    // first node needs no special case.
+    Node dummy(0);
+    Node *tail = &dummy;
+    while (a != nullptr && b != nullptr) {
+      if (b->value_ < a->value_) {
+        tail->next_ = b;
+        b = b->next_;
+      } else {
+        tail->next_ = a;
+        a = a->next_;
+      }
+      tail = tail->next_;
+    }
+    tail->next_ = a != nullptr ? a : b;
+    return dummy.next_;
+  }
+
+  // Rebuilds every prev_ link from the next_ links, after a sort or merge.
+  void FixPrevLinks() {
+    Node *prev = nullptr;
+    for (Node *node = head_; node != nullptr; node = node->next_) {
+      node->prev_ = prev;
+      prev = node;
+    }
+  }
+
+  Node *head_;
+  size_t size_;
+};
+
+// The baseline: copy into a vector, sort it, and rebuild the list.
+void CopySortRebuild(DLL &dll) {
+  std::vector<int> values;
+  values.reserve(dll.Size());
+  for (DLLIterator iter = dll.Begin(); iter != dll.End(); ++iter) {
+    values.push_back(*iter);
+  }
+  std::sort(values.begin(), values.end());
+  dll.Clear();
+  for (auto it = values.rbegin(); it != values.rend(); ++it) {
+    dll.InsertAtHead(*it);
+  }
+}
+
+void Print(DLL &dll) {
+  for (DLLIterator iter = dll.Begin(); iter != dll.End(); ++iter) {
+    std::cout << *iter << " ";
+  }
+  std::cout << std::endl;
+}
+
+bool IsSorted(DLL &dll) {
+  DLLIterator iter = dll.Begin();
+  if (iter == dll.End()) {
+    return true;
+  }
+  int previous = *iter;
+  for (++iter; iter != dll.End(); ++iter) {
+    if (*iter < previous) {
+      return false;
+    }
+    previous = *iter;
+  }
+  return true;
+}
+
+template <typename Fn>
+double TimeMs(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  DLL a;
+  for (int value : {5, 1, 4, 9, 2, 8}) {
+    a.InsertAtHead(value);
+  }
+  DLL b;
+  for (int value : {7, 3, 6, 0}) {
+    b.InsertAtHead(value);
+  }
+  a.Sort();
+  b.Sort();
+  std::cout << "a after Sort(): ";
+  Print(a);
+  std::cout << "b after Sort(): ";
+  Print(b);
+  a.MergeSorted(std::move(b));
+  std::cout << "a after MergeSorted(b): ";
+  Print(a);
+  std::cout << "b is now empty: " << (b.Size() == 0 ? "yes" : "no") << "\n\n";
+
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+  std::mt19937 rng(445);
+  std::vector<int> input(count);
+  for (int &value : input) {
+    value = static_cast<int>(rng());
+  }
+
+  DLL baseline;
+  DLL in_place;
+  for (int value : input) {
+    baseline.InsertAtHead(value);
+    in_place.InsertAtHead(value);
+  }
+  std::cout << count << " random values\n";
+  std::cout << "copy, sort, rebuild: " << TimeMs([&] { CopySortRebuild(baseline); }) << " ms, sorted "
+            << (IsSorted(baseline) ? "yes" : "no") << "\n";
+  std::cout << "in-place merge sort: " << TimeMs([&] { in_place.Sort(); }) << " ms, sorted "
+            << (IsSorted(in_place) ? "yes" : "no") << "\n";
+
+  // Merging two sorted halves: relinking versus copying both into a vector.
+  DLL left;
+  DLL right;
+  for (size_t i = 0; i < count; i++) {
+    (i % 2 == 0 ? left : right).InsertAtHead(input[i]);
+  }
+  left.Sort();
+  right.Sort();
+  DLL left_copy;
+  DLL right_copy;
+  for (size_t i = 0; i < count; i++) {
+    (i % 2 == 0 ? left_copy : right_copy).InsertAtHead(input[i]);
+  }
+  left_copy.Sort();
+  right_copy.Sort();
+
+  std::cout << "copy-based merge:    " << TimeMs([&] {
+    std::vector<int> merged;
+    merged.reserve(left_copy.Size() + right_copy.Size());
+    for (DLLIterator iter = left_copy.Begin(); iter != left_copy.End(); ++iter) {
+      merged.push_back(*iter);
+    }
+    for (DLLIterator iter = right_copy.Begin(); iter != right_copy.End(); ++iter) {
+      merged.push_back(*iter);
+    }
+    std::inplace_merge(merged.begin(), merged.begin() + static_cast<long>(left_copy.Size()), merged.end());
+    right_copy.Clear();
+    left_copy.Clear();
+    for (auto it = merged.rbegin(); it != merged.rend(); ++it) {
+      left_copy.InsertAtHead(*it);
+    }
+  }) << " ms\n";
+  std::cout << "MergeSorted:         " << TimeMs([&] { left.MergeSorted(std::move(right)); }) << " ms, sorted "
+            << (IsSorted(left) ? "yes" : "no") << "\n";
+
+  return 0;
+}
@@ -0,0 +1,479 @@
+/**
+ * @file epoch_dll.cpp
+ * @brief Tutorial code on letting readers traverse a doubly linked list while
+ * a writer inserts and removes nodes, using epoch-based reclamation.
+ */
+
+// With the DLL from iterator.cpp, a writer that removes a node deletes it
+// right away. A reader that is standing on that node, or is about to step
+// onto it, then reads freed memory. The simple fix is the std::shared_mutex
+// from rwlock.cpp: readers take it shared, the writer takes it exclusive.
+// That is correct, but every scan now waits for the writer, the writer waits
+// for every scan, and all readers bounce the mutex's cache line between cores
+// just to take a shared lock.
+
+// Epoch-based reclamation (EBR) lets readers run without any lock:
+//   1. Unlinking and freeing are separated. The writer unlinks a node so that
+//      no new reader can reach it, but only "retires" it instead of deleting
+//      it, tagging it with the current global epoch.
+//   2. A reader "pins" the global epoch for the duration of a traversal by
+//      copying it into its own slot, and clears the slot when it is done.
+//      Each slot sits on its own cache line, so readers never write to
+//      shared memory.
+//   3. From time to time the writer advances the global epoch and frees every
+//      retired node whose tag is older than the oldest pinned epoch. A reader
+//      that pinned after a node was retired started from the head, after the
+//      node was unlinked, so it cannot reach it. A reader that pinned before
+//      holds an epoch no newer than the tag, so the node is kept for it.
+// An unlinked node keeps its next_ pointer, so a reader standing on it simply
+// walks back into the live list.
+
+// Writers still serialize among themselves with a mutex. Only the readers
+// become lock-free, which is the common case for read-mostly lists.
+
+// Includes std::min and std::max.
+#include <algorithm>
+// Includes std::array, used for the reader slots.
+#include <array>
+// Includes std::atomic.
+#include <atomic>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::numeric_limits.
+#include <limits>
+// Includes the mutex library header.
+#include <mutex>
+// Includes the shared_mutex library header, used by the baseline.
+#include <shared_mutex>
+// Includes std::runtime_error.
+#include <stdexcept>
+// Includes the thread library header.
+#include <thread>
+// Includes std::pair.
+#include <utility>
+// Includes the vector container library header.
+#include <vector>
+
+constexpr size_t kCacheLineSize = 64;
+
+// Readers load next_ concurrently with the writer relinking it, so it is
+// atomic. prev_ is only used by the writer, under its mutex.
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  std::atomic<Node *> next_;
+  Node *prev_;
+  int value_;
+};
+
+// Tracks which epochs readers have pinned, and the nodes the writer retired.
+class EpochManager {
+ public:
+  static constexpr size_t kMaxReaders = 64;
+  // The value of a slot whose reader is not inside a traversal.
+  static constexpr uint64_t kIdle = std::numeric_limits<uint64_t>::max();
+
+  EpochManager() : global_epoch_(0), collect_at_(kCollectThreshold) {
+    for (Slot &slot : slots_) {
+      slot.epoch_.store(kIdle, std::memory_order_relaxed);
+    }
+  }
+
+  // Frees all remaining retired nodes. Must only run once no reader is
+  // pinned any more.
+  ~EpochManager() {
+    for (auto &[epoch, node] : retired_) {
+      delete node;
+    }
+  }
+
+  EpochManager(const EpochManager &) = delete;
+  EpochManager &operator=(const EpochManager &) = delete;
+
+  // Publishes the current global epoch in the calling thread's slot. Pins of
+  // one thread must not nest.
+  void Pin() {
+    Slot &slot = slots_[MySlot()];
+    // Acquire pairs with the release in Collect: a reader that sees epoch
+    // T + 1 also sees every unlink the writer made before advancing to it,
+    // so it cannot reach a node retired at T.
+    slot.epoch_.store(global_epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    // The writer's Collect has the matching fence. Together they guarantee
+    // that either Collect sees this slot, or this reader sees every unlink
+    // made before that Collect.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  void Unpin() { slots_[MySlot()].epoch_.store(kIdle, std::memory_order_release); }
+
+  // Hands an unlinked node over for deferred deletion. Called by the writer
+  // only, which also serializes access to retired_.
+  void Retire(Node *node) {
+    // The node was unlinked before this load, so any reader that pins the
+    // epoch read here or a later one no longer sees it.
+    retired_.emplace_back(global_epoch_.load(std::memory_order_acquire), node);
+    if (retired_.size() >= collect_at_) {
+      Collect();
+    }
+  }
+
+  size_t RetiredCount() const { return retired_.size(); }
+
+ private:
+  // Collecting scans every slot, so it is batched.
+  static constexpr size_t kCollectThreshold = 64;
+
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<uint64_t> epoch_;
+  };
+
+  // Advances the global epoch and frees every retired node that no pinned
+  // reader can still see.
+  void Collect() {
+    // Release publishes the unlinks of everything retired so far to readers
+    // that pin the new epoch.
+    global_epoch_.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = kIdle;
+    for (const Slot &slot : slots_) {
+      oldest = std::min(oldest, slot.epoch_.load(std::memory_order_acquire));
+    }
+
+    size_t kept = 0;
+    for (auto &[epoch, node] : retired_) {
+      if (epoch < oldest) {
+        delete node;
+      } else {
+        retired_[kept++] = {epoch, node};
+      }
+    }
+    retired_.resize(kept);
+    // If a slow reader keeps many nodes alive, wait for proportionally more
+    // retirements before scanning again, so retiring stays O(1) amortized.
+    collect_at_ = std::max(kCollectThreshold, 2 * kept);
+  }
+
+  // Threads lease a slot the first time they pin, and give it back when they
+  // exit, so short-lived reader threads do not use up the slots. Slots are
+  // shared by all lists, like the stripes of StripedCounter in
+  // concurrent_dll.cpp, but unlike stripes they cannot be shared by two
+  // threads, so running out of them is an error.
+  class SlotLease {
+   public:
+    SlotLease() {
+      std::scoped_lock lock(LeaseMutex());
+      std::vector<bool> &in_use = InUse();
+      for (index_ = 0; index_ < kMaxReaders && in_use[index_]; index_++) {
+      }
+      if (index_ == kMaxReaders) {
+        throw std::runtime_error("too many reader threads for EpochManager");
+      }
+      in_use[index_] = true;
+    }
+
+    ~SlotLease() {
+      std::scoped_lock lock(LeaseMutex());
+      InUse()[index_] = false;
+    }
+
+    size_t index_;
+  };
+
+  static std::mutex &LeaseMutex() {
+    static std::mutex m;
+    return m;
+  }
+
+  static std::vector<bool> &InUse() {
+    static std::vector<bool> in_use(kMaxReaders, false);
+    return in_use;
+  }
+
+  static size_t MySlot() {
+    thread_local SlotLease lease;
+    return lease.index_;
+  }
+
+  std::atomic<uint64_t> global_epoch_;
+  std::array<Slot, kMaxReaders> slots_;
+  std::vector<std::pair<uint64_t, Node *>> retired_;
+  size_t collect_at_;
+};
+
+// The iterator from iterator.cpp, with an acquire load to step to the next
+// node. It must only be used while the list is pinned by a ReadGuard.
+class DLLIterator {
+ public:
+  DLLIterator(Node *head) : curr_(head) {}
+
+  DLLIterator &operator++() {
+    curr_ = curr_->next_.load(std::memory_order_acquire);
+    return *this;
+  }
+
+  bool operator==(const DLLIterator &itr) const { return itr.curr_ == curr_; }
+
+  bool operator!=(const DLLIterator &itr) const { return itr.curr_ != curr_; }
+
+  int operator*() { return curr_->value_; }
+
+ private:
+  Node *curr_;
+};
+
+class EpochDLL {
+ public:
+  // Pins the list for as long as it is alive. Every traversal must hold one.
+  class ReadGuard {
+   public:
+    explicit ReadGuard(EpochDLL &list) : list_(list) { list_.epochs_.Pin(); }
+    ~ReadGuard() { list_.epochs_.Unpin(); }
+
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+
+   private:
+    EpochDLL &list_;
+  };
+
+  EpochDLL() : head_(nullptr), tail_(nullptr), size_(0) {}
+
+  // Must only run once every reader and writer is done with the list.
+  ~EpochDLL() {
+    Node *current = head_.load(std::memory_order_relaxed);
+    while (current != nullptr) {
+      Node *next = current->next_.load(std::memory_order_relaxed);
+      delete current;
+      current = next;
+    }
+  }
+
+  EpochDLL(const EpochDLL &) = delete;
+  EpochDLL &operator=(const EpochDLL &) = delete;
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    std::scoped_lock lock(write_m_);
+    Node *old_head = head_.load(std::memory_order_relaxed);
+    new_node->next_.store(old_head, std::memory_order_relaxed);
+    if (old_head != nullptr) {
+      old_head->prev_ = new_node;
+    } else {
+      tail_ = new_node;
+    }
+    // Release, so a reader that loads new_node also sees its fields.
+    head_.store(new_node, std::memory_order_release);
+    size_ += 1;
+  }
+
+  // Removes the tail and returns its value. Throws std::out_of_range if the
+  // list is empty. The node is retired, not deleted.
+  int PopBack() {
+    std::scoped_lock lock(write_m_);
+    if (tail_ == nullptr) {
+      throw std::out_of_range("PopBack on an empty EpochDLL");
+    }
+    Node *victim = tail_;
+    tail_ = victim->prev_;
+    if (tail_ != nullptr) {
+      tail_->next_.store(nullptr, std::memory_order_release);
+    } else {
+      head_.store(nullptr, std::memory_order_release);
+    }
+    size_ -= 1;
+    int value = victim->value_;
+    epochs_.Retire(victim);
+    return value;
+  }
+
+  DLLIterator Begin() { return DLLIterator(head_.load(std::memory_order_acquire)); }
+
+  DLLIterator End() { return DLLIterator(nullptr); }
+
+  size_t Size() {
+    std::scoped_lock lock(write_m_);
+    return size_;
+  }
+
+  size_t RetiredCount() {
+    std::scoped_lock lock(write_m_);
+    return epochs_.RetiredCount();
+  }
+
+ private:
+  std::mutex write_m_;
+  std::atomic<Node *> head_;
+  Node *tail_;
+  size_t size_;
+  EpochManager epochs_;
+};
+
+// The baseline: the same list with readers and the writer synchronized by a
+// std::shared_mutex, as in rwlock.cpp. Nodes are deleted immediately.
+class SharedMutexDLL {
+ public:
+  class ReadGuard {
+   public:
+    explicit ReadGuard(SharedMutexDLL &list) : lock_(list.m_) {}
+
+   private:
+    std::shared_lock<std::shared_mutex> lock_;
+  };
+
+  SharedMutexDLL() : head_(nullptr), tail_(nullptr) {}
+
+  ~SharedMutexDLL() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_.load(std::memory_order_relaxed);
+      delete current;
+      current = next;
+    }
+  }
+
+  SharedMutexDLL(const SharedMutexDLL &) = delete;
+  SharedMutexDLL &operator=(const SharedMutexDLL &) = delete;
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    std::unique_lock lock(m_);
+    new_node->next_.store(head_, std::memory_order_relaxed);
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    } else {
+      tail_ = new_node;
+    }
+    head_ = new_node;
+  }
+
+  int PopBack() {
+    Node *victim;
+    {
+      std::unique_lock lock(m_);
+      if (tail_ == nullptr) {
+        throw std::out_of_range("PopBack on an empty SharedMutexDLL");
+      }
+      victim = tail_;
+      tail_ = victim->prev_;
+      if (tail_ != nullptr) {
+        tail_->next_.store(nullptr, std::memory_order_relaxed);
+      } else {
+        head_ = nullptr;
+      }
+    }
+    int value = victim->value_;
+    delete victim;
+    return value;
+  }
+
+  DLLIterator Begin() { return DLLIterator(head_); }
+
+  DLLIterator End() { return DLLIterator(nullptr); }
+
+ private:
+  std::shared_mutex m_;
+  Node *head_;
+  Node *tail_;
+};
+
+struct Throughput {
+  double scans_per_second_;
+  double writes_per_second_;
+};
+
+// Runs the given number of readers, each scanning the whole list over and
+// over, while one writer keeps inserting at the head and popping the tail.
+template <typename List>
+Throughput MeasureThroughput(size_t readers, size_t list_size, std::chrono::milliseconds duration) {
+  List list;
+  for (size_t i = 0; i < list_size; i++) {
+    list.InsertAtHead(static_cast<int>(i));
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> scans{0};
+  size_t writes = 0;
+  std::thread writer([&] {
+    int next = static_cast<int>(list_size);
+    while (!stop.load(std::memory_order_relaxed)) {
+      list.InsertAtHead(next++);
+      list.PopBack();
+      writes += 2;
+    }
+  });
+  std::vector<std::thread> threads;
+  for (size_t r = 0; r < readers; r++) {
+    threads.emplace_back([&] {
+      size_t done = 0;
+      long long sink = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        typename List::ReadGuard guard(list);
+        for (DLLIterator iter = list.Begin(); iter != list.End(); ++iter) {
+          sink += *iter;
+        }
+        done += 1;
+      }
+      scans.fetch_add(done + (sink == 42 ? 1 : 0), std::memory_order_relaxed);
+    });
+  }
+
+  std::this_thread::sleep_for(duration);
+  stop.store(true, std::memory_order_relaxed);
+  writer.join();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(duration).count();
+  return {static_cast<double>(scans.load()) / seconds, static_cast<double>(writes) / seconds};
+}
+
+int main() {
+  EpochDLL dll;
+  for (int i = 10; i >= 1; i--) {
+    dll.InsertAtHead(i);
+  }
+
+  // A reader pins the list and holds an iterator while the writer pops every
+  // node it started from. The popped nodes stay allocated until the reader
+  // unpins, so the walk is safe; it ends where the writer cut the list off.
+  {
+    EpochDLL::ReadGuard guard(dll);
+    DLLIterator iter = dll.Begin();
+    std::thread writer([&dll] {
+      for (int i = 0; i < 100; i++) {
+        dll.InsertAtHead(100 + i);
+        dll.PopBack();
+      }
+    });
+    writer.join();
+    std::cout << "Reader pinned during 100 pops walked:";
+    for (; iter != dll.End(); ++iter) {
+      std::cout << " " << *iter;
+    }
+    std::cout << "\nRetired but not yet freed: " << dll.RetiredCount() << "\n";
+  }
+  // Once the reader has left, the next collection frees them.
+  for (int i = 0; i < 64; i++) {
+    dll.InsertAtHead(-i);
+    dll.PopBack();
+  }
+  std::cout << "After the reader unpinned and 64 more pops: " << dll.RetiredCount() << " retired\n\n";
+
+  const size_t list_size = 1000;
+  const auto duration = std::chrono::milliseconds(300);
+  std::cout << "Scans/s of a " << list_size << "-element list, and writes/s of one writer that inserts and pops "
+            << "concurrently (this machine has " << std::thread::hardware_concurrency() << " hardware threads)\n";
+  for (size_t readers : {1, 2, 4, 8}) {
+    Throughput locked = MeasureThroughput<SharedMutexDLL>(readers, list_size, duration);
+    Throughput epoch = MeasureThroughput<EpochDLL>(readers, list_size, duration);
+    std::cout << readers << " reader(s): shared_mutex " << locked.scans_per_second_ << " scans/s, "
+              << locked.writes_per_second_ << " writes/s; epochs " << epoch.scans_per_second_ << " scans/s, "
+              << epoch.writes_per_second_ << " writes/s\n";
+  }
+
+  return 0;
+}
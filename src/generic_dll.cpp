@@ -0,0 +1,247 @@
+/**
+ * @file generic_dll.cpp
+ * @brief Tutorial code on a templated doubly linked list with an allocator
+ * parameter, emplacement, and iterators that dereference to references.
+ */
+
+// The DLL in iterator.cpp and range_based_for.cpp is hardcoded to int, and
+// its iterator's operator* returns the value by copy. For an int that does
+// not matter, but a list of 200-byte records would copy 200 bytes on every
+// access, and the caller could never modify an element in place.
+
+// The DLL below is templated on the element type T and on an allocator, the
+// same way the STL containers are (see templated_classes.cpp for templated
+// classes in general):
+//   - operator* returns T& (or const T& for a const_iterator), so access is
+//     copy-free, and `for (auto &item : dll)` can modify the elements.
+//   - EmplaceAtHead(args...) constructs the element directly inside the new
+//     node from the constructor arguments, so not even the insert copies it.
+//   - Nodes are allocated through Alloc, rebound from T to Node<T> with
+//     std::allocator_traits, just like std::list does.
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::size_t.
+#include <cstddef>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::forward_iterator_tag.
+#include <iterator>
+// Includes std::allocator and std::allocator_traits.
+#include <memory>
+// Includes std::string.
+#include <string>
+// Includes std::conditional_t.
+#include <type_traits>
+// Includes std::forward and std::move.
+#include <utility>
+
+// The node now holds a T instead of an int. The constructor forwards its
+// arguments to T's constructor.
+template <typename T>
+struct Node {
+  template <typename... Args>
+  explicit Node(Args &&...args) : next_(nullptr), prev_(nullptr), value_(std::forward<Args>(args)...) {}
+
+  Node *next_;
+  Node *prev_;
+  T value_;
+};
+
+// One iterator template serves as both iterator (IsConst = false) and
+// const_iterator (IsConst = true). The only difference is whether operator*
+// hands out T& or const T&.
+template <typename T, bool IsConst>
+class DLLIterator {
+ public:
+  // These aliases let STL algorithms (and std::iterator_traits) work with
+  // this iterator.
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<IsConst, const T *, T *>;
+  using reference = std::conditional_t<IsConst, const T &, T &>;
+
+  explicit DLLIterator(Node<T> *curr) : curr_(curr) {}
+
+  // A non-const iterator converts to a const one, but not the other way.
+  operator DLLIterator<T, true>() const { return DLLIterator<T, true>(curr_); }
+
+  DLLIterator &operator++() {
+    curr_ = curr_->next_;
+    return *this;
+  }
+
+  DLLIterator operator++(int) {
+    DLLIterator temp = *this;
+    ++*this;
+    return temp;
+  }
+
+  bool operator==(const DLLIterator &itr) const { return itr.curr_ == curr_; }
+
+  bool operator!=(const DLLIterator &itr) const { return itr.curr_ != curr_; }
+
+  // Returns a reference to the element, not a copy of it.
+  reference operator*() const { return curr_->value_; }
+
+  pointer operator->() const { return &curr_->value_; }
+
+ private:
+  Node<T> *curr_;
+};
+
+template <typename T, typename Alloc = std::allocator<T>>
+class DLL {
+  // The allocator the user gave us allocates T. We need one that allocates
+  // Node<T>, which is what rebind_alloc gives us.
+  using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node<T>>;
+  using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+ public:
+  using iterator = DLLIterator<T, false>;
+  using const_iterator = DLLIterator<T, true>;
+
+  explicit DLL(const Alloc &alloc = Alloc()) : head_(nullptr), size_(0), alloc_(alloc) {}
+
+  ~DLL() {
+    Node<T> *current = head_;
+    while (current != nullptr) {
+      Node<T> *next = current->next_;
+      NodeTraits::destroy(alloc_, current);
+      NodeTraits::deallocate(alloc_, current, 1);
+      current = next;
+    }
+    head_ = nullptr;
+  }
+
+  DLL(const DLL &) = delete;
+  DLL &operator=(const DLL &) = delete;
+
+  // Constructs a new element at the head of the list from args, and returns
+  // a reference to it.
+  template <typename... Args>
+  T &EmplaceAtHead(Args &&...args) {
+    Node<T> *new_node = NodeTraits::allocate(alloc_, 1);
+    // If T's constructor throws, give the node back before passing the
+    // exception on, or it would leak.
+    try {
+      NodeTraits::construct(alloc_, new_node, std::forward<Args>(args)...);
+    } catch (...) {
+      NodeTraits::deallocate(alloc_, new_node, 1);
+      throw;
+    }
+    new_node->next_ = head_;
+
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    }
+
+    head_ = new_node;
+    size_ += 1;
+    return new_node->value_;
+  }
+
+  // Copies val into a new node at the head of the list.
+  void InsertAtHead(const T &val) { EmplaceAtHead(val); }
+
+  // Moves val into a new node at the head of the list.
+  void InsertAtHead(T &&val) { EmplaceAtHead(std::move(val)); }
+
+  iterator begin() { return iterator(head_); }
+  iterator end() { return iterator(nullptr); }
+  const_iterator begin() const { return const_iterator(head_); }
+  const_iterator end() const { return const_iterator(nullptr); }
+  const_iterator cbegin() const { return const_iterator(head_); }
+  const_iterator cend() const { return const_iterator(nullptr); }
+
+  size_t Size() const { return size_; }
+
+ private:
+  Node<T> *head_;
+  size_t size_;
+  NodeAlloc alloc_;
+};
+
+// A 200-byte record that counts how often it gets copied.
+struct Record {
+  static inline size_t copies = 0;
+
+  Record(int id, const char *name) : id_(id), balance_(0) {
+    for (size_t i = 0; i < sizeof(name_); i++) {
+      name_[i] = name[i];
+      if (name[i] == '\0') {
+        break;
+      }
+    }
+  }
+
+  Record(const Record &other) : id_(other.id_), balance_(other.balance_) {
+    for (size_t i = 0; i < sizeof(name_); i++) {
+      name_[i] = other.name_[i];
+    }
+    copies += 1;
+  }
+
+  int id_;
+  long long balance_;
+  char name_[184];
+};
+
+static_assert(sizeof(Record) == 200, "Record is meant to be a 200-byte payload");
+
+// Templated functions can now take any DLL, whatever its element type.
+template <typename T, typename Alloc>
+void Print(const DLL<T, Alloc> &dll) {
+  for (const T &item : dll) {
+    std::cout << item << " ";
+  }
+  std::cout << std::endl;
+}
+
+int main() {
+  // The element type is now a template parameter.
+  DLL<std::string> strings;
+  strings.InsertAtHead("list");
+  strings.InsertAtHead("linked");
+  strings.EmplaceAtHead(3, 'a');  // Constructs std::string(3, 'a') in place.
+  Print(strings);
+
+  // operator* returns a reference, so elements can be modified in place.
+  DLL<int> ints;
+  for (int i = 5; i >= 1; i--) {
+    ints.InsertAtHead(i);
+  }
+  for (int &item : ints) {
+    item *= 10;
+  }
+  Print(ints);
+
+  // Large records: neither inserting with EmplaceAtHead nor reading through
+  // a reference copies the record.
+  const size_t count = 1000000;
+  DLL<Record> records;
+  for (size_t i = 0; i < count; i++) {
+    records.EmplaceAtHead(static_cast<int>(i), "account");
+  }
+  std::cout << "Copies made while inserting " << count << " records: " << Record::copies << "\n";
+
+  auto start = std::chrono::steady_clock::now();
+  long long by_reference = 0;
+  for (const Record &record : records) {
+    by_reference += record.id_;
+  }
+  auto middle = std::chrono::steady_clock::now();
+  long long by_value = 0;
+  for (Record record : records) {  // What operator* returning by value forces on us.
+    by_value += record.id_;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout << "Scan by reference: " << std::chrono::duration<double, std::milli>(middle - start).count()
+            << " ms (sum " << by_reference << ")\n";
+  std::cout << "Scan by value:     " << std::chrono::duration<double, std::milli>(end - middle).count()
+            << " ms (sum " << by_value << "), " << Record::copies << " copies\n";
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file indexed_dll.cpp
+ * @brief Tutorial code on positional access into a doubly linked list.
+ */
+
+// In range_based_for.cpp, `iter + offset` walks offset links one at a time, so
+// jumping to position k of a list is O(k). That is fine for small lists, but
+// paging through a long list with it is quadratic.
+
+// A general purpose fix is an order-statistic index (a skip list or a balanced
+// tree with subtree sizes), which answers "which node is at position k" in
+// O(log n). Our DLL only ever inserts at the head, though, and that makes the
+// problem much simpler: the element at position k (counting from the head) is
+// always the (size - 1 - k)-th element that was inserted. So an index that
+// just remembers every node in insertion order answers positional queries in
+// O(1), and InsertAtHead keeps it up to date with one push_back.
+
+// The index is optional. It costs one pointer per element, and lists that
+// never do positional access can turn it off.
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::mt19937 for picking random positions.
+#include <random>
+// Includes the vector container library header, used for the index.
+#include <vector>
+
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  Node *next_;
+  Node *prev_;
+  int value_;
+};
+
+class DLL {
+ public:
+  // The index is built by InsertAtHead if indexed is true. Without it, At()
+  // and operator+ fall back to walking the list.
+  explicit DLL(bool indexed = false) : head_(nullptr), size_(0), indexed_(indexed) {}
+
+  ~DLL() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+    head_ = nullptr;
+  }
+
+  DLL(const DLL &) = delete;
+  DLL &operator=(const DLL &) = delete;
+
+  // The iterator remembers its position, so that operator+ can ask the list
+  // for the node at position + offset instead of walking there.
+  class DLLIterator {
+   public:
+    DLLIterator(const DLL *list, Node *curr, size_t pos) : list_(list), curr_(curr), pos_(pos) {}
+
+    DLLIterator &operator++() {
+      curr_ = curr_->next_;
+      pos_ += 1;
+      return *this;
+    }
+
+    bool operator!=(const DLLIterator &itr) const { return itr.curr_ != this->curr_; }
+
+    int operator*() { return curr_->value_; }
+
+    // Unlike range_based_for.cpp, operator+ does not modify this iterator; it
+    // returns a new one, just like `ptr + offset` does not modify ptr.
+    DLLIterator operator+(size_t offset) const {
+      if (list_->indexed_) {
+        size_t target = pos_ + offset;
+        return DLLIterator(list_, list_->NodeAt(target), target);
+      }
+      Node *node = curr_;
+      for (size_t i = 0; i < offset && node != nullptr; ++i) {
+        node = node->next_;
+      }
+      return DLLIterator(list_, node, pos_ + offset);
+    }
+
+   private:
+    const DLL *list_;
+    Node *curr_;
+    size_t pos_;
+  };
+
+  DLLIterator begin() { return DLLIterator(this, head_, 0); }
+
+  DLLIterator end() { return DLLIterator(this, nullptr, size_); }
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    new_node->next_ = head_;
+
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    }
+
+    head_ = new_node;
+    size_ += 1;
+
+    if (indexed_) {
+      by_insertion_.push_back(new_node);
+    }
+  }
+
+  // Returns the value at position k, counting from the head. k must be less
+  // than the size of the list.
+  int At(size_t k) { return *(begin() + k); }
+
+  size_t Size() const { return size_; }
+
+ private:
+  // Returns the node at position k, or nullptr if k is past the end. Only
+  // valid on an indexed list.
+  Node *NodeAt(size_t k) const { return k < size_ ? by_insertion_[size_ - 1 - k] : nullptr; }
+
+  Node *head_;
+  size_t size_;
+  bool indexed_;
+  // Every node, in insertion order. The head is always the last entry.
+  std::vector<Node *> by_insertion_;
+};
+
+// Builds a list of size elements and times `queries` random positional
+// lookups on it. Returns the average nanoseconds per lookup.
+double TimeRandomAccess(size_t size, bool indexed, size_t queries) {
+  DLL list(indexed);
+  for (size_t i = size; i > 0; i--) {
+    list.InsertAtHead(static_cast<int>(i - 1));
+  }
+
+  std::mt19937_64 rng(445);
+  std::uniform_int_distribution<size_t> position(0, size - 1);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < queries; i++) {
+    size_t k = position(rng);
+    int value = list.At(k);
+    // The list holds 0, 1, ..., size - 1, so the value is its own position.
+    if (static_cast<size_t>(value) != k) {
+      std::cout << "At(" << k << ") returned " << value << "\n";
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(queries);
+}
+
+int main() {
+  DLL dll(true);
+  dll.InsertAtHead(6);
+  dll.InsertAtHead(5);
+  dll.InsertAtHead(4);
+  dll.InsertAtHead(3);
+  dll.InsertAtHead(2);
+  dll.InsertAtHead(1);
+
+  std::cout << "Using range-based for statement\n";
+  for (const auto &item : dll) {
+    std::cout << item << " ";
+  }
+  std::cout << std::endl;
+
+  DLL::DLLIterator iter = dll.begin();
+  std::cout << "The first element: " << *iter << "\n";
+  std::cout << "The third element: " << *(iter + 2) << "\n";
+  std::cout << "The fifth element: " << dll.At(4) << "\n\n";
+
+  // Compare the two modes. Walking is O(n) per lookup, so it gets far fewer
+  // queries on the large lists to keep the run short.
+  for (size_t size : {size_t{1000}, size_t{1000000}, size_t{10000000}}) {
+    size_t walk_queries = size <= 1000 ? 10000 : 20;
+    double walk_ns = TimeRandomAccess(size, false, walk_queries);
+    double index_ns = TimeRandomAccess(size, true, 1000000);
+    std::cout << size << " elements: walk " << walk_ns << " ns/lookup, index " << index_ns << " ns/lookup\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * @file int_ptr_arena.cpp
+ * @brief Tutorial code on carving the ints managed by IntPtrManager-style
+ * wrappers out of a contiguous arena instead of the global heap.
+ */
+
+// IntPtrManager in wrapper_class.cpp calls `new int` in every constructor,
+// including the default one, and `delete` in its destructor. Ten million
+// managers mean ten million trips through malloc and free. Each 4-byte int
+// also takes up a 16 or 32 byte heap chunk somewhere on the heap, so scanning
+// all the values is a scan of scattered memory.
+
+// IntPtrManagerArena hands out ints from big blocks of 65536 slots instead:
+//   - A freed slot goes onto a free list that is threaded through the free
+//     slots themselves. Each slot is a union of the int and the index of the
+//     next free slot, so the free list needs no extra memory. Allocating pops
+//     the list, or takes the next never-used slot of the last block.
+//   - Blocks are aligned to their own size, so the block a pointer belongs to
+//     is found by masking off the low bits of the pointer. Its first slot
+//     holds the block's number.
+//   - A bitmap per block records which slots are live, so ForEach can scan
+//     all live values block by block, in memory order.
+// ArenaIntPtrManager is the wrapper: it owns one int of an arena, with the
+// same move-only semantics and interface as IntPtrManager.
+
+// This executable links in the allocation tracker (see alloc_tracking.cpp) to
+// count the allocations.
+
+// Includes the allocation tracker.
+#include "alloc_tracker/alloc_tracker.h"
+// Includes IntPtrManager, the baseline.
+#include "wrapper_class.h"
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::align_val_t.
+#include <new>
+// Includes std::length_error.
+#include <stdexcept>
+// Includes std::move.
+#include <utility>
+// Includes the vector container library header.
+#include <vector>
+
+class IntPtrManagerArena {
+ public:
+  static constexpr uint32_t kBlockShift = 16;
+  static constexpr uint32_t kSlotsPerBlock = uint32_t{1} << kBlockShift;
+
+  IntPtrManagerArena() : free_head_(kNone), next_unused_(kSlotsPerBlock), live_(0) {}
+
+  // Frees the blocks. Every ArenaIntPtrManager must be gone by then.
+  ~IntPtrManagerArena() {
+    for (Block &block : blocks_) {
+      operator delete[](block.slots_, std::align_val_t{kBlockBytes});
+    }
+  }
+
+  IntPtrManagerArena(const IntPtrManagerArena &) = delete;
+  IntPtrManagerArena &operator=(const IntPtrManagerArena &) = delete;
+
+  int *Allocate(int val) {
+    uint32_t index;
+    if (free_head_ != kNone) {
+      index = free_head_;
+      free_head_ = SlotAt(index).next_free_;
+    } else {
+      if (next_unused_ == kSlotsPerBlock) {
+        AddBlock();
+      }
+      index = (static_cast<uint32_t>(blocks_.size() - 1) << kBlockShift) | next_unused_++;
+    }
+    Block &block = blocks_[index >> kBlockShift];
+    uint32_t offset = index & (kSlotsPerBlock - 1);
+    block.live_[offset / 64] |= uint64_t{1} << (offset % 64);
+    live_ += 1;
+    Slot &slot = block.slots_[offset];
+    slot.value_ = val;
+    return &slot.value_;
+  }
+
+  // ptr must come from Allocate on this arena.
+  void Free(int *ptr) {
+    auto address = reinterpret_cast<uintptr_t>(ptr);
+    auto *base = reinterpret_cast<Slot *>(address & ~(uintptr_t{kBlockBytes} - 1));
+    uint32_t block_number = base[0].next_free_;
+    auto offset = static_cast<uint32_t>(reinterpret_cast<Slot *>(ptr) - base);
+    blocks_[block_number].live_[offset / 64] &= ~(uint64_t{1} << (offset % 64));
+    live_ -= 1;
+    reinterpret_cast<Slot *>(ptr)->next_free_ = free_head_;
+    free_head_ = (block_number << kBlockShift) | offset;
+  }
+
+  // Calls fn(value) for every live value, in memory order.
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    for (const Block &block : blocks_) {
+      for (uint32_t word = 0; word < kSlotsPerBlock / 64; word++) {
+        uint64_t bits = block.live_[word];
+        while (bits != 0) {
+          uint32_t offset = word * 64 + static_cast<uint32_t>(__builtin_ctzll(bits));
+          fn(block.slots_[offset].value_);
+          bits &= bits - 1;
+        }
+      }
+    }
+  }
+
+  size_t Size() const { return live_; }
+
+  size_t BlockCount() const { return blocks_.size(); }
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  union Slot {
+    int value_;
+    uint32_t next_free_;
+  };
+
+  static_assert(sizeof(Slot) == sizeof(int), "Slots must pack the values as tightly as an int array");
+
+  static constexpr size_t kBlockBytes = kSlotsPerBlock * sizeof(Slot);
+
+  // A slot's index is its block number shifted left by kBlockShift, plus its
+  // offset, in 32 bits. With this many blocks, no index reaches kNone, which
+  // ends the free list.
+  static constexpr size_t kMaxBlocks = kNone >> kBlockShift;
+
+  struct Block {
+    Slot *slots_;
+    std::vector<uint64_t> live_;
+  };
+
+  Slot &SlotAt(uint32_t index) { return blocks_[index >> kBlockShift].slots_[index & (kSlotsPerBlock - 1)]; }
+
+  void AddBlock() {
+    if (blocks_.size() == kMaxBlocks) {
+      throw std::length_error("IntPtrManagerArena is full");
+    }
+    auto *slots = static_cast<Slot *>(operator new[](kBlockBytes, std::align_val_t{kBlockBytes}));
+    // Slot 0 is never handed out. It records the block number for Free.
+    slots[0].next_free_ = static_cast<uint32_t>(blocks_.size());
+    blocks_.push_back(Block{slots, std::vector<uint64_t>(kSlotsPerBlock / 64, 0)});
+    next_unused_ = 1;
+  }
+
+  std::vector<Block> blocks_;
+  uint32_t free_head_;
+  // The next slot of the last block that has never been handed out.
+  uint32_t next_unused_;
+  size_t live_;
+};
+
+// IntPtrManager from wrapper_class.cpp, with its int in an arena.
+class ArenaIntPtrManager {
+ public:
+  explicit ArenaIntPtrManager(IntPtrManagerArena &arena) : arena_(&arena), ptr_(arena.Allocate(0)) {}
+
+  ArenaIntPtrManager(IntPtrManagerArena &arena, int val) : arena_(&arena), ptr_(arena.Allocate(val)) {}
+
+  ~ArenaIntPtrManager() {
+    if (ptr_) {
+      arena_->Free(ptr_);
+    }
+  }
+
+  ArenaIntPtrManager(ArenaIntPtrManager &&other) noexcept : arena_(other.arena_), ptr_(other.ptr_) {
+    other.ptr_ = nullptr;
+  }
+
+  ArenaIntPtrManager &operator=(ArenaIntPtrManager &&other) noexcept {
+    if (ptr_ == other.ptr_) {
+      return *this;
+    }
+    if (ptr_) {
+      arena_->Free(ptr_);
+    }
+    arena_ = other.arena_;
+    ptr_ = other.ptr_;
+    other.ptr_ = nullptr;
+    return *this;
+  }
+
+  ArenaIntPtrManager(const ArenaIntPtrManager &) = delete;
+  ArenaIntPtrManager &operator=(const ArenaIntPtrManager &) = delete;
+
+  void SetVal(int val) { *ptr_ = val; }
+
+  int GetVal() const { return *ptr_; }
+
+ private:
+  IntPtrManagerArena *arena_;
+  int *ptr_;
+};
+
+template <typename Fn>
+double TimeMs(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  IntPtrManagerArena arena;
+  {
+    ArenaIntPtrManager a(arena, 445);
+    std::cout << "1. Value of a is " << a.GetVal() << "\n";
+    a.SetVal(645);
+    std::cout << "2. Value of a is " << a.GetVal() << "\n";
+    ArenaIntPtrManager b(std::move(a));
+    std::cout << "Value of b is " << b.GetVal() << ", live values in the arena: " << arena.Size() << "\n";
+  }
+  // b's slot went back onto the free list, and the next manager reuses it.
+  ArenaIntPtrManager c(arena, 15445);
+  std::cout << "After b was destroyed, c reuses its slot: live values " << arena.Size() << ", blocks "
+            << arena.BlockCount() << "\n\n";
+
+  const size_t count = 10000000;
+  std::vector<IntPtrManager> heap_managers;
+  std::vector<ArenaIntPtrManager> arena_managers;
+  heap_managers.reserve(count);
+  arena_managers.reserve(count);
+
+  {
+    alloc_tracker::ScopedRegion region;
+    double create_ms = TimeMs([&] {
+      for (size_t i = 0; i < count; i++) {
+        heap_managers.emplace_back(static_cast<int>(i));
+      }
+    });
+    long long sum = 0;
+    double scan_ms = TimeMs([&] {
+      for (const IntPtrManager &manager : heap_managers) {
+        sum += manager.GetVal();
+      }
+    });
+    double destroy_ms = TimeMs([&] { heap_managers.clear(); });
+    std::cout << count << " IntPtrManagers: create " << create_ms << " ms, scan " << scan_ms << " ms (sum " << sum
+              << "), destroy " << destroy_ms << " ms, " << region.Delta().allocations_ << " allocations\n";
+  }
+  {
+    alloc_tracker::ScopedRegion region;
+    double create_ms = TimeMs([&] {
+      for (size_t i = 0; i < count; i++) {
+        arena_managers.emplace_back(arena, static_cast<int>(i));
+      }
+    });
+    long long sum = 0;
+    double scan_ms = TimeMs([&] { arena.ForEach([&sum](int value) { sum += value; }); });
+    double destroy_ms = TimeMs([&] { arena_managers.clear(); });
+    std::cout << count << " ArenaIntPtrManagers: create " << create_ms << " ms, scan " << scan_ms << " ms (sum "
+              << sum - c.GetVal() << "), destroy " << destroy_ms << " ms, " << region.Delta().allocations_
+              << " allocations\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,246 @@
+/**
+ * @file intrusive_ptr.cpp
+ * @brief Tutorial code on intrusive reference counting, as a cheaper
+ * alternative to std::shared_ptr.
+ */
+
+// A std::shared_ptr<Point> (see shared_ptr.cpp) is two pointers wide: one to
+// the Point and one to a separate control block that holds the reference
+// count. std::shared_ptr<Point>(new Point) therefore allocates twice, and
+// every copy, including the by-value copy in copy_shared_ptr_in_function,
+// does an atomic increment and later an atomic decrement on the control block.
+// make_shared saves the second allocation but keeps the two-pointer layout
+// and the atomics.
+
+// An intrusive pointer moves the count into the object itself. The object
+// derives from RefCounted, IntrusivePtr<T> holds only a T*, and copying it
+// increments the count inside the T it already points at:
+//   - sizeof(IntrusivePtr<T>) == sizeof(T *).
+//   - Creating an object allocates exactly once, with no control block.
+//   - The counting policy is a template parameter. AtomicCount is safe to
+//     share between threads. PlainCount is an ordinary integer, for objects
+//     that never leave one thread, whose copies then cost a plain add.
+// The price: a type has to opt in by deriving from RefCounted, and there are
+// no weak pointers.
+
+// This executable links in the allocation tracker (see alloc_tracking.cpp) to
+// show the allocations.
+
+// Includes the allocation tracker.
+#include "alloc_tracker/alloc_tracker.h"
+
+// Includes std::atomic.
+#include <atomic>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::shared_ptr, the baseline.
+#include <memory>
+// Includes std::string.
+#include <string>
+// Includes the thread library header.
+#include <thread>
+// Includes std::forward and std::swap.
+#include <utility>
+
+// A reference count that is safe to use from many threads. Incrementing can be
+// relaxed, because a thread can only copy a pointer it already holds. The
+// decrement must be acq_rel, so that every other owner's writes to the object
+// happen before the last owner deletes it.
+class AtomicCount {
+ public:
+  void Increment() { count_.fetch_add(1, std::memory_order_relaxed); }
+  // Returns true if this released the last reference.
+  bool Decrement() { return count_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+  uint32_t Get() const { return count_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint32_t> count_{0};
+};
+
+// A reference count for objects confined to one thread.
+class PlainCount {
+ public:
+  void Increment() { count_ += 1; }
+  bool Decrement() { return --count_ == 0; }
+  uint32_t Get() const { return count_; }
+
+ private:
+  uint32_t count_{0};
+};
+
+// Base class for objects managed by IntrusivePtr. The count is mutable so that
+// IntrusivePtr<const T> works too.
+template <typename CountPolicy>
+class RefCounted {
+ public:
+  void AddRef() const { count_.Increment(); }
+  bool Release() const { return count_.Decrement(); }
+  uint32_t UseCount() const { return count_.Get(); }
+
+ protected:
+  RefCounted() = default;
+  // Copying an object must not copy its count: the copy starts unowned.
+  RefCounted(const RefCounted &) {}
+  RefCounted &operator=(const RefCounted &) { return *this; }
+  ~RefCounted() = default;
+
+ private:
+  mutable CountPolicy count_;
+};
+
+template <typename T>
+class IntrusivePtr {
+ public:
+  IntrusivePtr() : ptr_(nullptr) {}
+
+  // Takes a reference to ptr, which may already be owned by other
+  // IntrusivePtrs. Since the count is in the object, that is always safe,
+  // unlike creating two std::shared_ptrs from one raw pointer.
+  explicit IntrusivePtr(T *ptr) : ptr_(ptr) {
+    if (ptr_ != nullptr) {
+      ptr_->AddRef();
+    }
+  }
+
+  ~IntrusivePtr() { Reset(); }
+
+  IntrusivePtr(const IntrusivePtr &other) : IntrusivePtr(other.ptr_) {}
+
+  IntrusivePtr(IntrusivePtr &&other) noexcept : ptr_(other.ptr_) { other.ptr_ = nullptr; }
+
+  // Taking the argument by value makes this both the copy and the move
+  // assignment, and handles self-assignment.
+  IntrusivePtr &operator=(IntrusivePtr other) noexcept {
+    std::swap(ptr_, other.ptr_);
+    return *this;
+  }
+
+  void Reset() {
+    if (ptr_ != nullptr && ptr_->Release()) {
+      delete ptr_;
+    }
+    ptr_ = nullptr;
+  }
+
+  T *Get() const { return ptr_; }
+  T &operator*() const { return *ptr_; }
+  T *operator->() const { return ptr_; }
+  explicit operator bool() const { return ptr_ != nullptr; }
+
+  uint32_t UseCount() const { return ptr_ != nullptr ? ptr_->UseCount() : 0; }
+
+ private:
+  T *ptr_;
+};
+
+// The counterpart of std::make_shared.
+template <typename T, typename... Args>
+IntrusivePtr<T> MakeIntrusive(Args &&...args) {
+  return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+// The Point class from shared_ptr.cpp, with the count built in.
+template <typename CountPolicy>
+class CountedPoint : public RefCounted<CountPolicy> {
+ public:
+  CountedPoint() : x_(0), y_(0) {}
+  CountedPoint(int x, int y) : x_(x), y_(y) {}
+  int GetX() const { return x_; }
+  int GetY() const { return y_; }
+  void SetX(int x) { x_ = x; }
+  void SetY(int y) { y_ = y; }
+
+ private:
+  int x_;
+  int y_;
+};
+
+// The Point class from shared_ptr.cpp.
+class Point {
+ public:
+  Point() : x_(0), y_(0) {}
+  Point(int x, int y) : x_(x), y_(y) {}
+  int GetX() const { return x_; }
+  int GetY() const { return y_; }
+
+ private:
+  int x_;
+  int y_;
+};
+
+using SharedPoint = CountedPoint<AtomicCount>;
+using LocalPoint = CountedPoint<PlainCount>;
+
+static_assert(sizeof(IntrusivePtr<SharedPoint>) == sizeof(SharedPoint *));
+static_assert(sizeof(std::shared_ptr<Point>) == 2 * sizeof(Point *));
+
+// The by-value copy from copy_shared_ptr_in_function, without the printing.
+// noinline keeps the compiler from optimizing the copy away at the call site.
+template <typename Ptr>
+__attribute__((noinline)) int CopyInFunction(Ptr point) {
+  return point->GetX();
+}
+
+template <typename Ptr>
+void TimeCopies(const std::string &name, const Ptr &point, size_t copies) {
+  auto start = std::chrono::steady_clock::now();
+  long long sum = 0;
+  for (size_t i = 0; i < copies; i++) {
+    sum += CopyInFunction(point);
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << name << ": " << std::chrono::duration<double, std::nano>(end - start).count() / copies
+            << " ns per by-value call (sum " << sum << ")\n";
+}
+
+template <typename Make>
+void CountAllocations(const std::string &name, Make make) {
+  alloc_tracker::ScopedRegion region;
+  for (int i = 0; i < 1000; i++) {
+    auto ptr = make();
+    auto copy = ptr;
+  }
+  alloc_tracker::Stats delta = region.Delta();
+  std::cout << name << ": " << delta.allocations_ / 1000.0 << " allocations, " << delta.bytes_allocated_ / 1000.0
+            << " bytes per object\n";
+}
+
+int main() {
+  // IntrusivePtr is used just like std::shared_ptr.
+  IntrusivePtr<SharedPoint> p1 = MakeIntrusive<SharedPoint>(2, 3);
+  std::cout << "Use count of p1: " << p1.UseCount() << "\n";
+  {
+    IntrusivePtr<SharedPoint> p2 = p1;
+    p2->SetX(445);
+    std::cout << "Use count of p1 after one copy: " << p1.UseCount() << ", x is now " << p1->GetX() << "\n";
+  }
+  IntrusivePtr<SharedPoint> p3 = std::move(p1);
+  std::cout << "p1 is " << (p1 ? "not empty" : "empty") << " after the move, p3 has use count " << p3.UseCount()
+            << "\n";
+  // The count lives in the object, so a second pointer made from the raw
+  // pointer joins the same count instead of double-freeing.
+  IntrusivePtr<SharedPoint> p4(p3.Get());
+  std::cout << "Use count after adopting the raw pointer again: " << p3.UseCount() << "\n\n";
+
+  std::cout << "sizeof: std::shared_ptr<Point> " << sizeof(std::shared_ptr<Point>) << " bytes, IntrusivePtr "
+            << sizeof(IntrusivePtr<SharedPoint>) << " bytes\n";
+  CountAllocations("shared_ptr<Point>(new Point)", [] { return std::shared_ptr<Point>(new Point(1, 2)); });
+  CountAllocations("make_shared<Point>", [] { return std::make_shared<Point>(1, 2); });
+  CountAllocations("MakeIntrusive<SharedPoint>", [] { return MakeIntrusive<SharedPoint>(1, 2); });
+  std::cout << "\n";
+
+  // libstdc++ quietly uses non-atomic counts in std::shared_ptr for as long
+  // as the program has never started a second thread. Real programs that
+  // share pointers have threads, so start (and finish) one first.
+  std::thread([] {}).join();
+  const size_t copies = 50000000;
+  TimeCopies("std::shared_ptr<Point>", std::make_shared<Point>(1, 2), copies);
+  TimeCopies("IntrusivePtr, AtomicCount", MakeIntrusive<SharedPoint>(1, 2), copies);
+  TimeCopies("IntrusivePtr, PlainCount", MakeIntrusive<LocalPoint>(1, 2), copies);
+
+  return 0;
+}
@@ -0,0 +1,233 @@
+/**
+ * @file lru_cache.cpp
+ * @brief Tutorial code on an O(1) LRU cache built from a doubly linked list
+ * and an unordered_map.
+ */
+
+// A least-recently-used (LRU) cache keeps at most `capacity` entries, and when
+// it is full it evicts the entry that was used longest ago. The classic O(1)
+// implementation combines the two structures from iterator.cpp and
+// unordered_maps.cpp:
+//   - a doubly linked list of entries, ordered from most recently used (head)
+//     to least recently used (tail). Since every node knows its prev_ and
+//     next_, a node can be unlinked and moved to the front in O(1), and the
+//     tail is the eviction victim.
+//   - an std::unordered_map from key to list node, so a lookup finds its node
+//     in O(1) on average.
+// The tricky part is keeping the two in sync when relinking, which is why it
+// is written once here.
+
+// Steady state is allocation-free: once the cache is full, an insert reuses
+// the evicted entry's list node, and it reuses the evicted entry's map node as
+// well through unordered_map::extract (C++17), which lets us change the key of
+// a map node without freeing and reallocating it. The buckets are reserved up
+// front, so the map never rehashes either. (Assigning K and V themselves may
+// still allocate if they are types like std::string.)
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::function, used for the eviction callback.
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::unique_ptr.
+#include <memory>
+// Includes std::mt19937 for the benchmark's key stream.
+#include <random>
+// Includes std::invalid_argument.
+#include <stdexcept>
+// Includes std::string.
+#include <string>
+// Includes the unordered_map container library header.
+#include <unordered_map>
+// Includes std::move.
+#include <utility>
+
+template <typename K, typename V, typename Hash = std::hash<K>>
+class LruCache {
+ public:
+  // Called with the key and value of every entry the cache evicts.
+  using EvictionCallback = std::function<void(const K &, const V &)>;
+
+  // Counters for monitoring the cache.
+  struct Stats {
+    size_t hits_;
+    size_t misses_;
+    size_t evictions_;
+  };
+
+  // capacity must be at least 1: a full cache evicts its tail, and an empty
+  // one has none.
+  explicit LruCache(size_t capacity, EvictionCallback on_evict = nullptr)
+      : capacity_(capacity), on_evict_(std::move(on_evict)), head_(nullptr), tail_(nullptr), stats_{0, 0, 0} {
+    if (capacity == 0) {
+      throw std::invalid_argument("LruCache capacity must be at least 1");
+    }
+    map_.reserve(capacity);
+  }
+
+  ~LruCache() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+  }
+
+  LruCache(const LruCache &) = delete;
+  LruCache &operator=(const LruCache &) = delete;
+
+  // Returns a pointer to the value for key and marks the entry as most
+  // recently used, or returns nullptr on a miss. The pointer stays valid until
+  // the entry is evicted.
+  V *Get(const K &key) {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      stats_.misses_ += 1;
+      return nullptr;
+    }
+    stats_.hits_ += 1;
+    MoveToFront(it->second);
+    return &it->second->value_;
+  }
+
+  // Inserts or updates key, and marks it as most recently used. If the cache
+  // is full, the least recently used entry is evicted first.
+  void Put(const K &key, V value) {
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+      it->second->value_ = std::move(value);
+      MoveToFront(it->second);
+      return;
+    }
+
+    if (map_.size() < capacity_) {
+      // The node is owned by the unique_ptr until the map holds it, so it is
+      // freed if emplace throws.
+      auto node = std::make_unique<Node>(key, std::move(value));
+      map_.emplace(key, node.get());
+      PushFront(node.release());
+      return;
+    }
+
+    // The cache is full: recycle the least recently used entry, both its list
+    // node and its map node, for the new key.
+    Node *victim = tail_;
+    if (on_evict_) {
+      on_evict_(victim->key_, victim->value_);
+    }
+    stats_.evictions_ += 1;
+
+    auto map_node = map_.extract(victim->key_);
+    map_node.key() = key;
+    map_.insert(std::move(map_node));
+
+    victim->key_ = key;
+    victim->value_ = std::move(value);
+    MoveToFront(victim);
+  }
+
+  size_t Size() const { return map_.size(); }
+
+  size_t Capacity() const { return capacity_; }
+
+  const Stats &GetStats() const { return stats_; }
+
+ private:
+  struct Node {
+    Node(const K &key, V value) : prev_(nullptr), next_(nullptr), key_(key), value_(std::move(value)) {}
+
+    Node *prev_;
+    Node *next_;
+    K key_;
+    V value_;
+  };
+
+  // Links a node that is not in the list in front of the head.
+  void PushFront(Node *node) {
+    node->prev_ = nullptr;
+    node->next_ = head_;
+    if (head_ != nullptr) {
+      head_->prev_ = node;
+    } else {
+      tail_ = node;
+    }
+    head_ = node;
+  }
+
+  // Takes a node that is in the list out of it.
+  void Unlink(Node *node) {
+    if (node->prev_ != nullptr) {
+      node->prev_->next_ = node->next_;
+    } else {
+      head_ = node->next_;
+    }
+    if (node->next_ != nullptr) {
+      node->next_->prev_ = node->prev_;
+    } else {
+      tail_ = node->prev_;
+    }
+  }
+
+  void MoveToFront(Node *node) {
+    if (node == head_) {
+      return;
+    }
+    Unlink(node);
+    PushFront(node);
+  }
+
+  size_t capacity_;
+  EvictionCallback on_evict_;
+  std::unordered_map<K, Node *, Hash> map_;
+  // head_ is the most recently used entry, tail_ the least recently used.
+  Node *head_;
+  Node *tail_;
+  Stats stats_;
+};
+
+int main() {
+  LruCache<int, std::string> cache(3, [](const int &key, const std::string &value) {
+    std::cout << "Evicted " << key << " -> " << value << "\n";
+  });
+
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  cache.Put(3, "three");
+  // Touching 1 makes 2 the least recently used entry.
+  std::cout << "Get(1): " << *cache.Get(1) << "\n";
+  // The cache is full, so this evicts 2.
+  cache.Put(4, "four");
+  std::cout << "Get(2): " << (cache.Get(2) == nullptr ? "miss" : "hit") << "\n";
+  // Updating an existing key does not evict anything.
+  cache.Put(3, "THREE");
+  std::cout << "Get(3): " << *cache.Get(3) << "\n";
+
+  const auto &stats = cache.GetStats();
+  std::cout << "hits " << stats.hits_ << ", misses " << stats.misses_ << ", evictions " << stats.evictions_
+            << "\n\n";
+
+  // Latency of a mixed get/put workload whose working set is twice the
+  // capacity, so about half of the lookups miss and evict.
+  const size_t capacity = 100000;
+  const size_t ops = 5000000;
+  LruCache<int, int> big(capacity);
+  std::mt19937 rng(445);
+  std::uniform_int_distribution<int> keys(0, 2 * capacity - 1);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ops; i++) {
+    int key = keys(rng);
+    if (big.Get(key) == nullptr) {
+      big.Put(key, key);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  const auto &big_stats = big.GetStats();
+  std::cout << ops << " get/put operations: "
+            << std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops)
+            << " ns/op, hits " << big_stats.hits_ << ", misses " << big_stats.misses_ << ", evictions "
+            << big_stats.evictions_ << "\n";
+
+  return 0;
+}
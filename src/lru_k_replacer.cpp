@@ -0,0 +1,352 @@
+/**
+ * @file lru_k_replacer.cpp
+ * @brief Tutorial code on an LRU-K frame replacer, the eviction policy of a
+ * database buffer pool.
+ */
+
+// A buffer pool keeps disk pages in a fixed number of memory frames, and when
+// it needs a free frame it asks a replacer which frame to evict. Plain LRU
+// (see lru_cache.cpp) works badly for databases: one sequential scan touches
+// every page of a table exactly once, and that is enough to push every hot
+// page out of the pool ("sequential flooding").
+
+// LRU-K looks further back. The backward k-distance of a frame is the time
+// since its k-th most recent access, and LRU-K evicts the frame with the
+// largest backward k-distance. A frame with fewer than k accesses has a
+// distance of +inf, so pages that were touched once by a scan are evicted
+// before pages with a real access history. Among several +inf frames, the one
+// with the oldest first access goes first.
+
+// The replacer does this in O(1) with two intrusive doubly linked lists. They
+// use the same prev_/next_ relinking as the DLL in iterator.cpp, but the links
+// live inside the replacer's own per-frame bookkeeping, so nothing is ever
+// allocated after construction:
+//   - the history list holds the frames with fewer than k accesses, in the
+//     order of their first access. A frame is appended on its first access,
+//     and unlinked once it reaches k accesses.
+//   - the access list holds one record for each of the last k accesses of
+//     every frame, in the order the accesses happened. A new access is always
+//     the latest one, so its record is simply appended, and the record that
+//     falls out of the frame's window of k accesses is unlinked. The first
+//     record of a frame in this list is its k-th most recent access, so the
+//     first frame on the list has the largest backward k-distance.
+// Evict takes the first evictable frame of the history list, or else the
+// frame of the first record on the access list that is evictable. The only
+// entries it ever skips belong to pinned (non-evictable) frames, and a buffer
+// pool pins just the pages in active use, so eviction is O(1) amortized.
+
+// All public functions take one mutex. Apart from Evict skipping pinned
+// frames, each call only does a constant amount of relinking while holding
+// it, so the critical sections stay short even with many workers.
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes the mutex library header.
+#include <mutex>
+// Includes std::optional, the return type of Evict.
+#include <optional>
+// Includes std::mt19937 for the demo workloads.
+#include <random>
+// Includes std::out_of_range and std::logic_error.
+#include <stdexcept>
+// Includes the thread library header.
+#include <thread>
+// Includes the unordered_map container library header, used by the demo.
+#include <unordered_map>
+// Includes the vector container library header.
+#include <vector>
+
+using frame_id_t = int32_t;
+
+class LruKReplacer {
+ public:
+  // Creates a replacer for frames [0, num_frames) that looks at the last k
+  // accesses of every frame. k must be at least 1.
+  LruKReplacer(size_t num_frames, size_t k)
+      : k_(k), evictable_size_(0), entries_(num_frames), records_(num_frames * k) {}
+
+  LruKReplacer(const LruKReplacer &) = delete;
+  LruKReplacer &operator=(const LruKReplacer &) = delete;
+
+  // Records that frame_id was accessed just now. A frame that is seen for the
+  // first time starts out non-evictable.
+  void RecordAccess(frame_id_t frame_id) {
+    std::scoped_lock lock(latch_);
+    FrameEntry &entry = EntryFor(frame_id);
+
+    // A frame's k records are used as a ring buffer. next_slot_ is where the
+    // new access goes, which is also the oldest access once the ring is full.
+    AccessRecord *record = &records_[frame_id * k_ + entry.next_slot_];
+    if (entry.count_ == k_) {
+      access_list_.Unlink(record);
+    }
+    record->frame_id_ = frame_id;
+    access_list_.PushBack(record);
+    entry.next_slot_ = (entry.next_slot_ + 1) % k_;
+
+    if (entry.count_ < k_) {
+      entry.count_ += 1;
+      if (entry.count_ == 1) {
+        history_list_.PushBack(&entry);
+      }
+      if (entry.count_ == k_) {
+        history_list_.Unlink(&entry);
+      }
+    }
+  }
+
+  // Marks a frame as evictable or not. Only evictable frames count towards
+  // Size() and can be returned by Evict(). Does nothing for a frame that has
+  // no recorded access.
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) {
+    std::scoped_lock lock(latch_);
+    FrameEntry &entry = EntryFor(frame_id);
+    if (entry.count_ == 0 || entry.evictable_ == set_evictable) {
+      return;
+    }
+    entry.evictable_ = set_evictable;
+    if (set_evictable) {
+      evictable_size_ += 1;
+    } else {
+      evictable_size_ -= 1;
+    }
+  }
+
+  // Evicts the evictable frame with the largest backward k-distance, forgets
+  // its access history, and returns it. Returns std::nullopt if no frame is
+  // evictable.
+  std::optional<frame_id_t> Evict() {
+    std::scoped_lock lock(latch_);
+    // Frames with fewer than k accesses (+inf) go first, oldest first access
+    // first.
+    for (FrameEntry *entry = history_list_.Front(); entry != nullptr; entry = entry->next_) {
+      if (entry->evictable_) {
+        auto frame_id = static_cast<frame_id_t>(entry - entries_.data());
+        Forget(frame_id);
+        return frame_id;
+      }
+    }
+    // Every frame left in the history list is pinned, so any record of a
+    // frame with fewer than k accesses is skipped here as well.
+    for (AccessRecord *record = access_list_.Front(); record != nullptr; record = record->next_) {
+      if (entries_[record->frame_id_].evictable_) {
+        frame_id_t frame_id = record->frame_id_;
+        Forget(frame_id);
+        return frame_id;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Forgets the access history of an evictable frame, for example when its
+  // page is deleted. Does nothing for a frame that has no recorded access.
+  // Removing a non-evictable frame is an error.
+  void Remove(frame_id_t frame_id) {
+    std::scoped_lock lock(latch_);
+    FrameEntry &entry = EntryFor(frame_id);
+    if (entry.count_ == 0) {
+      return;
+    }
+    if (!entry.evictable_) {
+      throw std::logic_error("cannot remove a non-evictable frame");
+    }
+    Forget(frame_id);
+  }
+
+  // Returns the number of evictable frames.
+  size_t Size() {
+    std::scoped_lock lock(latch_);
+    return evictable_size_;
+  }
+
+ private:
+  // A doubly linked list of objects that carry their own prev_ and next_
+  // pointers.
+  template <typename Entry>
+  class IntrusiveList {
+   public:
+    Entry *Front() const { return head_; }
+
+    void PushBack(Entry *entry) {
+      entry->prev_ = tail_;
+      entry->next_ = nullptr;
+      if (tail_ != nullptr) {
+        tail_->next_ = entry;
+      } else {
+        head_ = entry;
+      }
+      tail_ = entry;
+    }
+
+    void Unlink(Entry *entry) {
+      if (entry->prev_ != nullptr) {
+        entry->prev_->next_ = entry->next_;
+      } else {
+        head_ = entry->next_;
+      }
+      if (entry->next_ != nullptr) {
+        entry->next_->prev_ = entry->prev_;
+      } else {
+        tail_ = entry->prev_;
+      }
+      entry->prev_ = nullptr;
+      entry->next_ = nullptr;
+    }
+
+   private:
+    Entry *head_{nullptr};
+    Entry *tail_{nullptr};
+  };
+
+  // The replacer's bookkeeping for one frame. The links are its hook in the
+  // history list.
+  struct FrameEntry {
+    FrameEntry *prev_{nullptr};
+    FrameEntry *next_{nullptr};
+    size_t next_slot_{0};
+    // The number of recorded accesses, capped at k.
+    size_t count_{0};
+    bool evictable_{false};
+  };
+
+  // One of the last k accesses of a frame, linked into the access list.
+  struct AccessRecord {
+    AccessRecord *prev_{nullptr};
+    AccessRecord *next_{nullptr};
+    frame_id_t frame_id_{0};
+  };
+
+  FrameEntry &EntryFor(frame_id_t frame_id) {
+    if (frame_id < 0 || static_cast<size_t>(frame_id) >= entries_.size()) {
+      throw std::out_of_range("invalid frame id");
+    }
+    return entries_[frame_id];
+  }
+
+  // Unlinks everything the replacer knows about an evictable frame.
+  void Forget(frame_id_t frame_id) {
+    FrameEntry &entry = entries_[frame_id];
+    if (entry.count_ < k_) {
+      history_list_.Unlink(&entry);
+    }
+    // The live records are slots [0, count_) of the ring: either it has not
+    // wrapped yet, or count_ == k and every slot is live.
+    for (size_t slot = 0; slot < entry.count_; slot++) {
+      access_list_.Unlink(&records_[frame_id * k_ + slot]);
+    }
+    entry.next_slot_ = 0;
+    entry.count_ = 0;
+    entry.evictable_ = false;
+    evictable_size_ -= 1;
+  }
+
+  size_t k_;
+  size_t evictable_size_;
+  std::vector<FrameEntry> entries_;
+  // k access records per frame, in one allocation.
+  std::vector<AccessRecord> records_;
+  IntrusiveList<FrameEntry> history_list_;
+  IntrusiveList<AccessRecord> access_list_;
+  std::mutex latch_;
+};
+
+// A tiny buffer pool simulation. A small hot set of pages is looked up over
+// and over while a sequential scan reads every page of a large table once,
+// interleaved with the lookups. Returns the hit ratio of the hot lookups.
+double HotHitRatio(size_t k) {
+  const size_t num_frames = 64;
+  const int hot_pages = 48;
+  const int table_pages = 100000;
+  LruKReplacer replacer(num_frames, k);
+  std::unordered_map<int, frame_id_t> page_table;
+  std::vector<int> frame_to_page(num_frames, -1);
+  frame_id_t next_free = 0;
+
+  // Returns true on a hit.
+  auto access = [&](int page) {
+    auto it = page_table.find(page);
+    frame_id_t frame;
+    bool hit = it != page_table.end();
+    if (hit) {
+      frame = it->second;
+    } else {
+      if (next_free < static_cast<frame_id_t>(num_frames)) {
+        frame = next_free++;
+      } else {
+        frame = *replacer.Evict();
+        page_table.erase(frame_to_page[frame]);
+      }
+      page_table[page] = frame;
+      frame_to_page[frame] = page;
+    }
+    replacer.RecordAccess(frame);
+    replacer.SetEvictable(frame, true);  // The page is unpinned right away.
+    return hit;
+  };
+
+  std::mt19937 rng(445);
+  std::uniform_int_distribution<int> hot(0, hot_pages - 1);
+  size_t hot_hits = 0;
+  for (int page = hot_pages; page < table_pages; page++) {
+    hot_hits += access(hot(rng)) ? 1 : 0;
+    access(page);
+  }
+  return static_cast<double>(hot_hits) / static_cast<double>(table_pages - hot_pages);
+}
+
+int main() {
+  LruKReplacer replacer(7, 2);
+  // Frames 1..6 are accessed once each, then frame 1 a second time. Only
+  // frame 1 has two accesses, so every other frame has distance +inf.
+  for (frame_id_t frame = 1; frame <= 6; frame++) {
+    replacer.RecordAccess(frame);
+    replacer.SetEvictable(frame, true);
+  }
+  replacer.RecordAccess(1);
+  replacer.SetEvictable(6, false);
+  std::cout << "Evictable frames: " << replacer.Size() << "\n";
+  std::cout << "Eviction order:";
+  while (std::optional<frame_id_t> victim = replacer.Evict()) {
+    std::cout << " " << *victim;
+  }
+  std::cout << "\n(frame 6 is pinned; frame 1 goes last because it is the only one with 2 accesses)\n\n";
+
+  // Sequential flooding: plain LRU (k = 1) against LRU-2.
+  std::cout << "Hot set hit ratio during a sequential scan: LRU " << HotHitRatio(1) << ", LRU-2 "
+            << HotHitRatio(2) << "\n\n";
+
+  // 32 workers hammer one replacer with access/pin/unpin/evict calls.
+  const size_t num_frames = 4096;
+  const int workers = 32;
+  const int ops_per_worker = 100000;
+  LruKReplacer shared(num_frames, 2);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int w = 0; w < workers; w++) {
+    threads.emplace_back([&shared, w] {
+      std::mt19937 rng(w);
+      std::uniform_int_distribution<frame_id_t> frames(0, num_frames - 1);
+      for (int i = 0; i < ops_per_worker; i++) {
+        frame_id_t frame = frames(rng);
+        shared.RecordAccess(frame);
+        shared.SetEvictable(frame, i % 4 != 0);
+        if (i % 16 == 0) {
+          shared.Evict();
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << workers << " workers: " << static_cast<double>(workers) * ops_per_worker / seconds / 1e6
+            << " M accesses/s, " << shared.Size() << " evictable frames at the end\n";
+
+  return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * @file owning_ptr_bench.cpp
+ * @brief Benchmark and compile-time checks showing that owning pointer
+ * wrappers cost nothing over raw pointers.
+ */
+
+// Pointer<T> (spring2024/s24_my_ptr.h), IntPtrManager (wrapper_class.h) and
+// std::unique_ptr<T> all wrap one raw pointer. A good wrapper should compile
+// down to exactly the code we would write by hand with new, delete and
+// pointer assignments. This file checks that in two ways, on the very classes
+// the tutorials use, so a change to them that adds overhead fails here.
+
+// At compile time, for every wrapper:
+//   - sizeof and alignof equal those of int *: the wrapper adds no bytes.
+//   - moving and destroying are noexcept, so containers move it instead of
+//     falling back to copying, which they do for throwing moves
+//     (std::move_if_noexcept).
+// A wrapper that holds nothing but its pointer is also trivially relocatable:
+// moving it and destroying the source could be a memcpy. C++17 cannot
+// express that property (it has been proposed for a later standard as
+// std::is_trivially_relocatable), so this file does not claim to check it.
+
+// At runtime, it times the four things an owning pointer does: construction
+// (which allocates), move construction, move assignment, and destruction
+// (which frees), in tight loops over a million objects, and compares each
+// wrapper with the same loops written with raw pointers. The program exits
+// with a non-zero status if a wrapper is clearly slower, so ctest catches a
+// regression.
+
+// This target is built with -O2 and NDEBUG, like a release build. That matters
+// for Pointer<int>: in the Debug build of the tutorial, it defaults to
+// LogTracePolicy and prints every allocation.
+
+// Includes Pointer<T>.
+#include "spring2024/s24_my_ptr.h"
+// Includes IntPtrManager.
+#include "wrapper_class.h"
+
+// Includes std::min.
+#include <algorithm>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::unique_ptr.
+#include <memory>
+// Includes placement new.
+#include <new>
+// Includes std::string.
+#include <string>
+// Includes the type traits checked below.
+#include <type_traits>
+// Includes std::move.
+#include <utility>
+// Includes the vector container library header.
+#include <vector>
+
+#ifndef NDEBUG
+#error "owning_ptr_bench must be built with NDEBUG, so that Pointer<T> does not print"
+#endif
+static_assert(std::is_same_v<Pointer<int>, Pointer<int, HeapPolicy<int>, NoTracePolicy<int>>>,
+              "a release build Pointer<int> must not trace");
+
+// All compile-time checks for one owning pointer type.
+template <typename Ptr>
+constexpr bool IsZeroOverhead() {
+  static_assert(sizeof(Ptr) == sizeof(int *), "must be exactly as big as a raw pointer");
+  static_assert(alignof(Ptr) == alignof(int *), "must be aligned like a raw pointer");
+  static_assert(std::is_nothrow_move_constructible_v<Ptr>, "move construction must be noexcept");
+  static_assert(std::is_nothrow_move_assignable_v<Ptr>, "move assignment must be noexcept");
+  static_assert(std::is_nothrow_destructible_v<Ptr>, "destruction must be noexcept");
+  static_assert(!std::is_copy_constructible_v<Ptr>, "an owning pointer must not be copyable");
+  return true;
+}
+
+static_assert(IsZeroOverhead<Pointer<int>>());
+static_assert(IsZeroOverhead<IntPtrManager>());
+static_assert(IsZeroOverhead<std::unique_ptr<int>>());
+
+// Keeps the compiler from optimizing away a value we computed but never use.
+template <typename T>
+void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Nanoseconds per operation for each of the four phases.
+struct Result {
+  double construct_;
+  double move_construct_;
+  double move_assign_;
+  double destroy_;
+};
+
+template <typename Fn>
+double NsPerOp(size_t ops, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ops);
+}
+
+// Runs the four phases for a wrapper type over raw storage, so every phase
+// does exactly one kind of operation: construct into a, move-construct b from
+// a, move-assign b back into a, destroy both.
+template <typename Ptr>
+Result Measure(size_t count) {
+  std::vector<std::aligned_storage_t<sizeof(Ptr), alignof(Ptr)>> a_storage(count);
+  std::vector<std::aligned_storage_t<sizeof(Ptr), alignof(Ptr)>> b_storage(count);
+  auto *a = reinterpret_cast<Ptr *>(a_storage.data());
+  auto *b = reinterpret_cast<Ptr *>(b_storage.data());
+
+  Result result;
+  result.construct_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      if constexpr (std::is_same_v<Ptr, std::unique_ptr<int>>) {
+        new (&a[i]) Ptr(new int(static_cast<int>(i)));
+      } else {
+        new (&a[i]) Ptr(static_cast<int>(i));
+      }
+    }
+  });
+  result.move_construct_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      new (&b[i]) Ptr(std::move(a[i]));
+    }
+    DoNotOptimize(b[count - 1]);
+  });
+  result.move_assign_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      a[i] = std::move(b[i]);
+    }
+    DoNotOptimize(a[count - 1]);
+  });
+  result.destroy_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      a[i].~Ptr();
+      b[i].~Ptr();
+    }
+  });
+  return result;
+}
+
+// The same four phases, written by hand with raw pointers.
+Result MeasureRaw(size_t count) {
+  std::vector<int *> a(count);
+  std::vector<int *> b(count);
+
+  Result result;
+  result.construct_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      a[i] = new int(static_cast<int>(i));
+    }
+  });
+  result.move_construct_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      b[i] = a[i];
+      a[i] = nullptr;
+    }
+    DoNotOptimize(b[count - 1]);
+  });
+  result.move_assign_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      if (a[i] != b[i]) {
+        delete a[i];
+        a[i] = b[i];
+        b[i] = nullptr;
+      }
+    }
+    DoNotOptimize(a[count - 1]);
+  });
+  result.destroy_ = NsPerOp(count, [&] {
+    for (size_t i = 0; i < count; i++) {
+      delete a[i];
+      delete b[i];
+    }
+  });
+  return result;
+}
+
+// Runs measure `runs` times and keeps the fastest time of each phase, which
+// filters out most of the noise from other processes.
+template <typename Fn>
+Result Best(size_t runs, Fn measure) {
+  Result best = measure();
+  for (size_t i = 1; i < runs; i++) {
+    Result result = measure();
+    best.construct_ = std::min(best.construct_, result.construct_);
+    best.move_construct_ = std::min(best.move_construct_, result.move_construct_);
+    best.move_assign_ = std::min(best.move_assign_, result.move_assign_);
+    best.destroy_ = std::min(best.destroy_, result.destroy_);
+  }
+  return best;
+}
+
+// A wrapper is flagged if a phase takes more than kTolerance times as long as
+// with raw pointers, plus kSlackNs. The slack keeps the sub-nanosecond move
+// phases from flagging on noise. Real overhead, like a trace call that
+// prints, costs far more than that.
+constexpr double kTolerance = 1.5;
+constexpr double kSlackNs = 2.0;
+
+bool WithinBudget(double wrapper, double raw) { return wrapper <= raw * kTolerance + kSlackNs; }
+
+// Prints the result, and returns false if any phase is over budget.
+bool Report(const std::string &name, const Result &result, const Result &raw) {
+  bool ok = WithinBudget(result.construct_, raw.construct_) &&
+            WithinBudget(result.move_construct_, raw.move_construct_) &&
+            WithinBudget(result.move_assign_, raw.move_assign_) && WithinBudget(result.destroy_, raw.destroy_);
+  std::cout << name << "\t" << result.construct_ << "\t" << result.move_construct_ << "\t" << result.move_assign_
+            << "\t" << result.destroy_ << (ok ? "" : "\tSLOWER THAN RAW POINTERS") << "\n";
+  return ok;
+}
+
+int main() {
+  const size_t count = 1000000;
+  const size_t runs = 5;
+  Result raw = Best(runs, [&] { return MeasureRaw(count); });
+  Result pointer = Best(runs, [&] { return Measure<Pointer<int>>(count); });
+  Result manager = Best(runs, [&] { return Measure<IntPtrManager>(count); });
+  Result unique = Best(runs, [&] { return Measure<std::unique_ptr<int>>(count); });
+
+  std::cout << "ns/op over " << count << " objects, best of " << runs << " runs\n";
+  std::cout << "type\t\tconstruct\tmove\tmove=\tdestroy\n";
+  Report("int *\t", raw, raw);
+  bool ok = Report("Pointer<int>", pointer, raw);
+  ok = Report("IntPtrManager", manager, raw) && ok;
+  ok = Report("unique_ptr<int>", unique, raw) && ok;
+  if (!ok) {
+    std::cout << "A wrapper took more than " << kTolerance << "x the raw pointer time plus " << kSlackNs
+              << " ns in some phase.\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,318 @@
+/**
+ * @file parallel_dll.cpp
+ * @brief Tutorial code on parallel for_each and reduce over a doubly linked
+ * list.
+ */
+
+// Splitting a scan of a std::vector across threads is easy: thread i takes the
+// i-th slice of indices. A linked list has no indices, and finding the node
+// where the i-th slice starts means walking the list, which is the very work
+// we wanted to split.
+
+// The DLL in this file solves that by leaving a marker every kSegmentSize
+// inserts: it remembers the node that was just inserted. Because nodes are
+// only ever added at the head, a marker never moves, and the markers cut the
+// list into segments of exactly kSegmentSize nodes (plus a shorter one at the
+// head). ParallelForEach and ParallelReduce hand each worker a contiguous run
+// of segments, so no worker has to walk to its starting point.
+
+// The workers are the threads of a WorkerPool, which are started once and
+// shared by every list, so a scan does not pay for starting threads.
+
+// Includes std::min.
+#include <algorithm>
+// Includes std::atomic, used in the ParallelForEach demo.
+#include <atomic>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::condition_variable, used by the worker pool.
+#include <condition_variable>
+// Includes std::strtoull for parsing the element count.
+#include <cstdlib>
+// Includes std::function, used to queue tasks.
+#include <functional>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::numeric_limits.
+#include <limits>
+// Includes std::mutex.
+#include <mutex>
+// Includes the queue container adaptor, used for pending tasks.
+#include <queue>
+// Includes the thread library header.
+#include <thread>
+// Includes the vector container library header.
+#include <vector>
+
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  Node *next_;
+  Node *prev_;
+  int value_;
+};
+
+class DLLIterator {
+ public:
+  DLLIterator(Node *head) : curr_(head) {}
+
+  DLLIterator &operator++() {
+    curr_ = curr_->next_;
+    return *this;
+  }
+
+  bool operator==(const DLLIterator &itr) const { return itr.curr_ == curr_; }
+
+  bool operator!=(const DLLIterator &itr) const { return itr.curr_ != curr_; }
+
+  int operator*() { return curr_->value_; }
+
+ private:
+  Node *curr_;
+};
+
+// A fixed set of threads that run queued tasks in FIFO order. Tasks must not
+// throw.
+class WorkerPool {
+ public:
+  explicit WorkerPool(size_t num_threads) : stop_(false) {
+    for (size_t i = 0; i < num_threads; i++) {
+      threads_.emplace_back([this] { Loop(); });
+    }
+  }
+
+  // Finishes the queued tasks, then stops the threads.
+  ~WorkerPool() {
+    {
+      std::scoped_lock lock(m_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  void Submit(std::function<void()> task) {
+    {
+      std::scoped_lock lock(m_);
+      tasks_.push(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  // The pool every DLL uses, with one thread per core. It is started on first
+  // use.
+  static WorkerPool &Shared() {
+    static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+  }
+
+ private:
+  void Loop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(m_);
+        cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::queue<std::function<void()>> tasks_;
+  bool stop_;
+  std::vector<std::thread> threads_;
+};
+
+class DLL {
+ public:
+  // The number of nodes between two segment markers.
+  static constexpr size_t kSegmentSize = 1 << 16;
+
+  DLL() : head_(nullptr), size_(0) {}
+
+  ~DLL() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+    head_ = nullptr;
+  }
+
+  DLL(const DLL &) = delete;
+  DLL &operator=(const DLL &) = delete;
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    new_node->next_ = head_;
+
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    }
+
+    head_ = new_node;
+    size_ += 1;
+
+    if (size_ % kSegmentSize == 0) {
+      markers_.push_back(new_node);
+    }
+  }
+
+  DLLIterator Begin() { return DLLIterator(head_); }
+
+  DLLIterator End() { return DLLIterator(nullptr); }
+
+  size_t Size() const { return size_; }
+
+  // Calls fn(value) on every element, using up to num_threads threads. fn is
+  // called concurrently, so it must be safe to call from several threads. The
+  // order of the calls is unspecified.
+  template <typename Fn>
+  void ParallelForEach(Fn fn, size_t num_threads) {
+    RunOnSegments(num_threads, [&fn](Node *begin, Node *end, size_t) {
+      for (Node *node = begin; node != end; node = node->next_) {
+        fn(node->value_);
+      }
+    });
+  }
+
+  // Reduces the list to one value. Each thread folds its nodes into a partial
+  // result starting from identity with accumulate(T, int), and the partial
+  // results are then folded together with combine(T, T).
+  template <typename T, typename Accumulate, typename Combine>
+  T ParallelReduce(T identity, Accumulate accumulate, Combine combine, size_t num_threads) {
+    // Each partial result gets its own cache line. That keeps the workers from
+    // false sharing, and keeps T = bool away from std::vector<bool>, whose
+    // elements share words and so cannot be written concurrently.
+    struct alignas(64) Partial {
+      T value_;
+    };
+    std::vector<Partial> partials(std::max<size_t>(num_threads, 1), Partial{identity});
+    RunOnSegments(num_threads, [&](Node *begin, Node *end, size_t worker) {
+      T partial = identity;
+      for (Node *node = begin; node != end; node = node->next_) {
+        partial = accumulate(partial, node->value_);
+      }
+      partials[worker].value_ = partial;
+    });
+    T result = identity;
+    for (const Partial &partial : partials) {
+      result = combine(result, partial.value_);
+    }
+    return result;
+  }
+
+ private:
+  // Splits the list into at most num_threads runs of whole segments, and runs
+  // work(begin, end, worker) on each run: the first run on the calling thread,
+  // and the others on the shared WorkerPool. [begin, end) is a half-open range
+  // of nodes, end may be nullptr, and worker is the index of the run. Returns
+  // once every run is done.
+  template <typename Work>
+  void RunOnSegments(size_t num_threads, Work work) {
+    // Segment boundaries in iteration order: the head, every marker from the
+    // newest to the oldest, and finally nullptr.
+    std::vector<Node *> bounds;
+    bounds.reserve(markers_.size() + 2);
+    bounds.push_back(head_);
+    for (auto it = markers_.rbegin(); it != markers_.rend(); ++it) {
+      bounds.push_back(*it);
+    }
+    bounds.push_back(nullptr);
+
+    size_t segments = bounds.size() - 1;
+    size_t workers = std::min(std::max<size_t>(num_threads, 1), segments);
+    auto run = [&](size_t w) { work(bounds[segments * w / workers], bounds[segments * (w + 1) / workers], w); };
+
+    std::mutex m;
+    std::condition_variable done;
+    size_t remaining = workers - 1;
+    for (size_t w = 1; w < workers; w++) {
+      WorkerPool::Shared().Submit([&, w] {
+        run(w);
+        // Notify under the lock: once remaining is 0, the caller may return
+        // and destroy done.
+        std::scoped_lock lock(m);
+        remaining -= 1;
+        done.notify_one();
+      });
+    }
+    run(0);
+    std::unique_lock lock(m);
+    done.wait(lock, [&] { return remaining == 0; });
+  }
+
+  Node *head_;
+  size_t size_;
+  // markers_[i] is the (i + 1) * kSegmentSize-th node ever inserted.
+  std::vector<Node *> markers_;
+};
+
+int main(int argc, char *argv[]) {
+  DLL dll;
+  for (int i = 200000; i >= 1; i--) {
+    dll.InsertAtHead(i);
+  }
+
+  size_t threads = std::max(4u, std::thread::hardware_concurrency());
+  auto add = [](long long acc, int value) { return acc + value; };
+  auto sum = [](long long a, long long b) { return a + b; };
+  auto min = [](int a, int b) { return std::min(a, b); };
+  auto max = [](int a, int b) { return std::max(a, b); };
+  auto count_even = [](size_t acc, int value) { return acc + (value % 2 == 0 ? 1 : 0); };
+  auto add_counts = [](size_t a, size_t b) { return a + b; };
+  auto any_above = [](bool acc, int value) { return acc || value > 199999; };
+  auto either = [](bool a, bool b) { return a || b; };
+
+  std::cout << "Aggregates over 1..200000 with " << threads << " threads\n";
+  std::cout << "sum:   " << dll.ParallelReduce(0LL, add, sum, threads) << "\n";
+  std::cout << "min:   " << dll.ParallelReduce(std::numeric_limits<int>::max(), min, min, threads) << "\n";
+  std::cout << "max:   " << dll.ParallelReduce(std::numeric_limits<int>::min(), max, max, threads) << "\n";
+  std::cout << "evens: " << dll.ParallelReduce(size_t{0}, count_even, add_counts, threads) << "\n";
+  std::cout << "any > 199999: " << std::boolalpha << dll.ParallelReduce(false, any_above, either, threads)
+            << std::noboolalpha << "\n";
+
+  std::atomic<long long> for_each_sum{0};
+  dll.ParallelForEach([&for_each_sum](int value) { for_each_sum.fetch_add(value, std::memory_order_relaxed); },
+                      threads);
+  std::cout << "sum via ParallelForEach: " << for_each_sum.load() << "\n\n";
+
+  // Compare a single-threaded walk with the parallel reduce on a long list.
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+  DLL big;
+  for (size_t i = 0; i < count; i++) {
+    big.InsertAtHead(static_cast<int>(i % 1000));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  long long serial = 0;
+  for (DLLIterator iter = big.Begin(); iter != big.End(); ++iter) {
+    serial += *iter;
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << count << " elements, serial walk: " << std::chrono::duration<double, std::milli>(end - start).count()
+            << " ms (sum " << serial << ")\n";
+
+  for (size_t t : {1, 2, 4, 8, 16}) {
+    start = std::chrono::steady_clock::now();
+    long long parallel = big.ParallelReduce(0LL, add, sum, t);
+    end = std::chrono::steady_clock::now();
+    std::cout << t << " thread(s): " << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms (sum " << parallel << ")\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file pooled_dll.cpp
+ * @brief Tutorial code on backing a doubly linked list with a node pool.
+ */
+
+// The DLL in iterator.cpp and range_based_for.cpp calls `new Node` for every
+// InsertAtHead, and its destructor calls `delete` once per node. Under an
+// insert-heavy load the general purpose allocator ends up being most of the
+// work, and tearing down a list of N nodes costs N calls to free.
+
+// In this file the DLL owns a NodePool. The pool carves nodes out of large
+// slabs, hands them out from a free list, and takes them back onto that free
+// list when the list pops a node. Since Node is trivially destructible, the
+// DLL destructor does not have to visit the nodes at all: it just releases
+// the slabs, which costs O(slabs) instead of O(nodes).
+
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes std::strtoull for parsing the element count.
+#include <cstdlib>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes placement new.
+#include <new>
+// Includes std::is_trivially_destructible.
+#include <type_traits>
+// Includes the vector container library header, used for the slab list.
+#include <vector>
+
+// This is the definition of the Node struct, used in our DLL.
+struct Node {
+  Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
+
+  Node *next_;
+  Node *prev_;
+  int value_;
+};
+
+// Releasing a whole slab without running any destructors is only correct
+// because a Node owns nothing.
+static_assert(std::is_trivially_destructible<Node>::value, "NodePool skips Node destructors");
+
+// A slab (arena) allocator for Nodes. Nodes are handed out from the free list
+// first, and otherwise bump-allocated from the current slab. A slab is never
+// returned to the system before the pool itself dies.
+class NodePool {
+ public:
+  // The number of nodes in one slab. 4096 nodes of 24 bytes is 96KiB.
+  static constexpr size_t kSlabSize = 4096;
+
+  NodePool() : free_list_(nullptr), next_free_slot_(kSlabSize) {}
+
+  // The destructor releases every slab at once.
+  ~NodePool() {
+    for (Node *slab : slabs_) {
+      ::operator delete(slab);
+    }
+  }
+
+  // The pool owns raw memory, so it must not be copied.
+  NodePool(const NodePool &) = delete;
+  NodePool &operator=(const NodePool &) = delete;
+
+  // Returns a new node holding val.
+  Node *Allocate(int val) {
+    Node *memory;
+    if (free_list_ != nullptr) {
+      // Pop a recycled node off the free list. Free nodes are linked through
+      // their next_ field.
+      memory = free_list_;
+      free_list_ = free_list_->next_;
+    } else {
+      if (next_free_slot_ == kSlabSize) {
+        slabs_.push_back(static_cast<Node *>(::operator new(sizeof(Node) * kSlabSize)));
+        next_free_slot_ = 0;
+      }
+      memory = slabs_.back() + next_free_slot_;
+      next_free_slot_ += 1;
+    }
+    return new (memory) Node(val);
+  }
+
+  // Gives node back to the pool, so that the next Allocate can reuse it.
+  void Deallocate(Node *node) {
+    node->next_ = free_list_;
+    free_list_ = node;
+  }
+
+  size_t SlabCount() const { return slabs_.size(); }
+
+ private:
+  std::vector<Node *> slabs_;
+  Node *free_list_;
+  // The index of the next never-used node in slabs_.back().
+  size_t next_free_slot_;
+};
+
+// This class implements a C++ style iterator for the pooled DLL. It is the
+// same iterator as in iterator.cpp; the pool does not change how nodes are
+// linked.
+class DLLIterator {
+ public:
+  DLLIterator(Node *head) : curr_(head) {}
+
+  DLLIterator &operator++() {
+    curr_ = curr_->next_;
+    return *this;
+  }
+
+  DLLIterator operator++(int) {
+    DLLIterator temp = *this;
+    ++*this;
+    return temp;
+  }
+
+  bool operator==(const DLLIterator &itr) const { return itr.curr_ == curr_; }
+
+  bool operator!=(const DLLIterator &itr) const { return itr.curr_ != curr_; }
+
+  int operator*() { return curr_->value_; }
+
+ private:
+  Node *curr_;
+};
+
+// This is the DLL from iterator.cpp, except that its nodes come from a pool
+// that the list owns.
+class DLL {
+ public:
+  DLL() : head_(nullptr), size_(0) {}
+
+  // Nothing to do here: pool_'s destructor releases every slab, and with
+  // them every node. There is no walk over the list.
+  ~DLL() = default;
+
+  DLL(const DLL &) = delete;
+  DLL &operator=(const DLL &) = delete;
+
+  // Function for inserting val at the head of the DLL.
+  void InsertAtHead(int val) {
+    Node *new_node = pool_.Allocate(val);
+    new_node->next_ = head_;
+
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    }
+
+    head_ = new_node;
+    size_ += 1;
+  }
+
+  // Function for removing the head of the DLL. The node goes back to the
+  // pool's free list, and the next InsertAtHead reuses it.
+  void PopFront() {
+    if (head_ == nullptr) {
+      return;
+    }
+    Node *old_head = head_;
+    head_ = head_->next_;
+    if (head_ != nullptr) {
+      head_->prev_ = nullptr;
+    }
+    pool_.Deallocate(old_head);
+    size_ -= 1;
+  }
+
+  DLLIterator Begin() { return DLLIterator(head_); }
+
+  DLLIterator End() { return DLLIterator(nullptr); }
+
+  size_t Size() const { return size_; }
+
+  size_t SlabCount() const { return pool_.SlabCount(); }
+
+ private:
+  NodePool pool_;
+  Node *head_;
+  size_t size_;
+};
+
+// The DLL from iterator.cpp, which allocates and frees every node on its own.
+// It is used as the baseline below.
+class HeapDLL {
+ public:
+  HeapDLL() : head_(nullptr), size_(0) {}
+
+  ~HeapDLL() {
+    Node *current = head_;
+    while (current != nullptr) {
+      Node *next = current->next_;
+      delete current;
+      current = next;
+    }
+    head_ = nullptr;
+  }
+
+  void InsertAtHead(int val) {
+    Node *new_node = new Node(val);
+    new_node->next_ = head_;
+    if (head_ != nullptr) {
+      head_->prev_ = new_node;
+    }
+    head_ = new_node;
+    size_ += 1;
+  }
+
+ private:
+  Node *head_;
+  size_t size_;
+};
+
+// Builds a list of count elements and destroys it, timing both phases.
+template <typename List>
+void TimeInsertAndTeardown(size_t count, const char *name) {
+  auto *list = new List();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    list->InsertAtHead(static_cast<int>(i));
+  }
+  auto inserted = std::chrono::steady_clock::now();
+  delete list;
+  auto destroyed = std::chrono::steady_clock::now();
+
+  double insert_ns = std::chrono::duration<double, std::nano>(inserted - start).count();
+  double teardown_ms = std::chrono::duration<double, std::milli>(destroyed - inserted).count();
+  std::cout << name << ": " << insert_ns / static_cast<double>(count) << " ns/insert, teardown " << teardown_ms
+            << " ms\n";
+}
+
+// The main function shows the usage of the pooled DLL, and then compares it
+// with the heap-allocated DLL. The number of elements can be passed as the
+// first argument.
+int main(int argc, char *argv[]) {
+  DLL dll;
+  dll.InsertAtHead(6);
+  dll.InsertAtHead(5);
+  dll.InsertAtHead(4);
+  dll.InsertAtHead(3);
+  dll.InsertAtHead(2);
+  dll.InsertAtHead(1);
+
+  std::cout << "Printing elements of the pooled DLL\n";
+  for (DLLIterator iter = dll.Begin(); iter != dll.End(); ++iter) {
+    std::cout << *iter << " ";
+  }
+  std::cout << std::endl;
+
+  // Popping and re-inserting recycles nodes through the pool's free list, so
+  // no new slab is needed.
+  dll.PopFront();
+  dll.PopFront();
+  dll.InsertAtHead(0);
+  std::cout << "After two PopFront calls and one InsertAtHead\n";
+  for (DLLIterator iter = dll.Begin(); iter != dll.End(); ++iter) {
+    std::cout << *iter << " ";
+  }
+  std::cout << std::endl;
+  std::cout << dll.Size() << " elements live in " << dll.SlabCount() << " slab(s)\n\n";
+
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  TimeInsertAndTeardown<HeapDLL>(count, "heap DLL  ");
+  TimeInsertAndTeardown<DLL>(count, "pooled DLL");
+
+  return 0;
+}
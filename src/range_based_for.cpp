@@ -1,5 +1,6 @@
 #include <cstddef>
 #include <iostream>
+#include <utility>
 
 struct Node {
   Node(int val) : next_(nullptr), prev_(nullptr), value_(val) {}
@@ -11,7 +12,7 @@ struct Node {
 
 class DLL {
 public:
-  DLL() : head_(nullptr), size_(0) {}
+  DLL() : head_(nullptr), tail_(nullptr), size_(0) {}
 
   ~DLL() {
     Node *current = head_;
@@ -21,20 +22,28 @@ public:
       current = next;
     }
     head_ = nullptr;
+    tail_ = nullptr;
   }
 
   // 1. 嵌套实现一个迭代器类，它维护一个数据成员用于指向可迭代对象的一个元素
   // 在这个类中，需要实现：a. 重载前缀++运算符，用于推进迭代器，b. 重载!=运算符，用于判断是否到达可迭代对象的末尾
   // c. 重载*解引用运算符，进而通过迭代器对象获得其指向的可迭代对象的对应元素
+  // d. 重载前缀--运算符，使迭代器可以双向移动。end() 的 curr_ 为 nullptr，--end() 需要回到尾结点，
+  // 因此迭代器还需要记住它所属的链表
   class DLLIterator {
   public:
-    explicit DLLIterator(Node *head) : curr_(head) {}
+    DLLIterator(Node *curr, const DLL *list) : curr_(curr), list_(list) {}
 
     DLLIterator &operator++() {
       curr_ = curr_->next_;
       return *this;
     }
 
+    DLLIterator &operator--() {
+      curr_ = curr_ == nullptr ? list_->tail_ : curr_->prev_;
+      return *this;
+    }
+
     bool operator!=(const DLLIterator &itr) const {
       return itr.curr_ != this->curr_;
     }
@@ -49,13 +58,16 @@ public:
     }
 
   private:
+    friend class DLL;
+
     Node *curr_;
+    const DLL *list_;
   };
 
   // 2. 在可迭代类中，定义 begin() 方法与 end() 方法，这两个方法返回一个迭代器对象，分别指向开头元素与最后一个元素之后位置（不指向任何元素，仅作为迭代结束的标志）
-  DLLIterator begin() { return DLLIterator(head_); }
+  DLLIterator begin() { return DLLIterator(head_, this); }
 
-  DLLIterator end() { return DLLIterator(nullptr); }
+  DLLIterator end() { return DLLIterator(nullptr, this); }
 
   void InsertAtHead(int val) {
     Node *new_node = new Node(val);
@@ -66,11 +78,93 @@ public:
     }
 
     head_ = new_node;
+    if (tail_ == nullptr) {
+      tail_ = new_node;
+    }
+    size_ += 1;
+  }
+
+  // 3. 维护尾指针 tail_ 后，尾部插入、头尾删除、拼接都只需要修改常数个指针，时间复杂度均为 O(1)
+  void InsertAtTail(int val) {
+    Node *new_node = new Node(val);
+    new_node->prev_ = tail_;
+
+    if (tail_ != nullptr) {
+      tail_->next_ = new_node;
+    }
+
+    tail_ = new_node;
+    if (head_ == nullptr) {
+      head_ = new_node;
+    }
     size_ += 1;
   }
 
+  // 删除并返回头结点的值，调用前链表不能为空
+  int PopFront() {
+    Node *old_head = head_;
+    int val = old_head->value_;
+    head_ = old_head->next_;
+    if (head_ != nullptr) {
+      head_->prev_ = nullptr;
+    } else {
+      tail_ = nullptr;
+    }
+    delete old_head;
+    size_ -= 1;
+    return val;
+  }
+
+  // 删除并返回尾结点的值，调用前链表不能为空
+  int PopBack() {
+    Node *old_tail = tail_;
+    int val = old_tail->value_;
+    tail_ = old_tail->prev_;
+    if (tail_ != nullptr) {
+      tail_->next_ = nullptr;
+    } else {
+      head_ = nullptr;
+    }
+    delete old_tail;
+    size_ -= 1;
+    return val;
+  }
+
+  // 把 other 的所有结点整体移动到 pos 之前（pos 为 end() 时接到尾部），只修改指针，不分配、不拷贝结点，之后 other 为空
+  void Splice(DLLIterator pos, DLL &other) {
+    if (&other == this || other.head_ == nullptr) {
+      return;
+    }
+    Node *next = pos.curr_;
+    Node *prev = next != nullptr ? next->prev_ : tail_;
+
+    other.head_->prev_ = prev;
+    other.tail_->next_ = next;
+    if (prev != nullptr) {
+      prev->next_ = other.head_;
+    } else {
+      head_ = other.head_;
+    }
+    if (next != nullptr) {
+      next->prev_ = other.tail_;
+    } else {
+      tail_ = other.tail_;
+    }
+
+    size_ += other.size_;
+    other.head_ = nullptr;
+    other.tail_ = nullptr;
+    other.size_ = 0;
+  }
+
+  // 把 other 接到尾部
+  void Concat(DLL &&other) { Splice(end(), other); }
+
+  size_t Size() const { return size_; }
+
 private:
   Node *head_{nullptr};
+  Node *tail_{nullptr};
   size_t size_;
 };
 
@@ -101,5 +195,24 @@ int main() {
   iter = iter + 2;
   std::cout << "The third element: " << *iter << "\n";
 
+  std::cout << "Test the tail operations\n";
+  dll.InsertAtTail(7);
+  std::cout << "PopFront: " << dll.PopFront() << ", PopBack: " << dll.PopBack() << "\n";
+
+  DLL other;
+  other.InsertAtTail(100);
+  other.InsertAtTail(200);
+  dll.Splice(dll.begin() + 1, other);
+  DLL more;
+  more.InsertAtTail(300);
+  dll.Concat(std::move(more));
+
+  std::cout << "After Splice and Concat, iterating backwards with operator--\n";
+  for (DLL::DLLIterator back = dll.end(); back != dll.begin();) {
+    --back;
+    std::cout << *back << " ";
+  }
+  std::cout << std::endl;
+
   return 0; 
 }
\ No newline at end of file
@@ -0,0 +1,280 @@
+/**
+ * @file slot_map.cpp
+ * @brief Tutorial code on a generational slot map, which stores objects
+ * densely and hands out handles instead of pointers.
+ */
+
+// Code in the style of unique_ptr.cpp gives every object its own
+// std::unique_ptr<Point>, i.e. its own heap allocation. With thousands of
+// objects created and destroyed over time, the Points end up scattered over
+// the heap, and a loop over all of them takes a cache miss per object.
+// Pointers also cannot say whether the object they point to still exists.
+
+// A slot map fixes both:
+//   - The values live densely in one std::vector, so iterating over all live
+//     values is a scan of contiguous memory.
+//   - Other code refers to a value with a 64-bit Handle: a 32-bit slot index
+//     and a 32-bit generation. The slot says where the value currently is
+//     in the dense vector. Erasing a value bumps its slot's generation, so
+//     every handle to it becomes stale and is detected as such, even after
+//     the slot is reused.
+//   - Erase moves the last value into the hole ("swap and pop"), keeping the
+//     values dense, and fixes up the moved value's slot. Insert, erase and
+//     lookup are all O(1).
+// The catch: values move when others are erased, so a T* or T& into the map
+// is only valid until the next erase or insert. Handles stay valid.
+
+// Includes std::max and std::shuffle.
+#include <algorithm>
+// Includes std::chrono for timing.
+#include <chrono>
+// Includes fixed width integer types.
+#include <cstdint>
+// Includes std::cout (printing) for demo purposes.
+#include <iostream>
+// Includes std::unique_ptr, used by the baseline.
+#include <memory>
+// Includes std::mt19937.
+#include <random>
+// Includes std::move and std::forward.
+#include <utility>
+// Includes the vector container library header.
+#include <vector>
+
+// Refers to a value in a SlotMap.
+struct Handle {
+  uint32_t index_;
+  uint32_t generation_;
+
+  bool operator==(const Handle &other) const { return index_ == other.index_ && generation_ == other.generation_; }
+  bool operator!=(const Handle &other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(Handle) == 8, "A handle is meant to be 64 bits");
+
+template <typename T>
+class SlotMap {
+ public:
+  using iterator = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  SlotMap() : free_head_(kNone) {}
+
+  // Constructs a value in place and returns its handle. If T's constructor
+  // (or an allocation) throws, the map is left unchanged.
+  template <typename... Args>
+  Handle Emplace(Args &&...args) {
+    // Everything that can throw happens first: growing the vectors, then
+    // constructing the value. After that, nothing below can fail.
+    GrowIfFull(slot_of_);
+    if (free_head_ == kNone) {
+      GrowIfFull(slots_);
+    }
+    values_.emplace_back(std::forward<Args>(args)...);
+
+    uint32_t index;
+    if (free_head_ != kNone) {
+      index = free_head_;
+      free_head_ = slots_[index].target_;
+    } else {
+      index = static_cast<uint32_t>(slots_.size());
+      slots_.push_back(Slot{0, 0});
+    }
+    slots_[index].target_ = static_cast<uint32_t>(values_.size() - 1);
+    slot_of_.push_back(index);
+    return Handle{index, slots_[index].generation_};
+  }
+
+  Handle Insert(T value) { return Emplace(std::move(value)); }
+
+  // Returns the value for handle, or nullptr if it was erased.
+  T *Get(Handle handle) {
+    if (!Contains(handle)) {
+      return nullptr;
+    }
+    return &values_[slots_[handle.index_].target_];
+  }
+
+  // The generation alone is not enough: a handle made up by hand, or one that
+  // survived the generation wrapping around, can carry the current generation
+  // of a free slot. A live slot is also the slot of the value it points at.
+  bool Contains(Handle handle) const {
+    if (handle.index_ >= slots_.size()) {
+      return false;
+    }
+    const Slot &slot = slots_[handle.index_];
+    return slot.generation_ == handle.generation_ && slot.target_ < values_.size() &&
+           slot_of_[slot.target_] == handle.index_;
+  }
+
+  // Erases the value for handle. Returns false if it was already erased.
+  bool Erase(Handle handle) {
+    if (!Contains(handle)) {
+      return false;
+    }
+    Slot &slot = slots_[handle.index_];
+    uint32_t hole = slot.target_;
+    uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+    if (hole != last) {
+      values_[hole] = std::move(values_[last]);
+      slot_of_[hole] = slot_of_[last];
+      slots_[slot_of_[hole]].target_ = hole;
+    }
+    values_.pop_back();
+    slot_of_.pop_back();
+
+    // A new generation invalidates every handle to the erased value. (After
+    // 2^32 reuses of one slot, generations wrap around.)
+    slot.generation_ += 1;
+    slot.target_ = free_head_;
+    free_head_ = handle.index_;
+    return true;
+  }
+
+  // Returns the handle of the value at position pos of the iteration order.
+  Handle HandleAt(size_t pos) const {
+    uint32_t index = slot_of_[pos];
+    return Handle{index, slots_[index].generation_};
+  }
+
+  size_t Size() const { return values_.size(); }
+
+  void Reserve(size_t capacity) {
+    values_.reserve(capacity);
+    slot_of_.reserve(capacity);
+    slots_.reserve(capacity);
+  }
+
+  // Iteration is over the dense values, in no particular order.
+  iterator begin() { return values_.begin(); }
+  iterator end() { return values_.end(); }
+  const_iterator begin() const { return values_.begin(); }
+  const_iterator end() const { return values_.end(); }
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  // For a live slot, target_ is the position of its value in values_. For a
+  // free slot, it is the next free slot, so the free slots form a list.
+  struct Slot {
+    uint32_t target_;
+    uint32_t generation_;
+  };
+
+  // Makes sure the next push_back onto v cannot throw, growing v
+  // geometrically like push_back would.
+  template <typename U>
+  static void GrowIfFull(std::vector<U> &v) {
+    if (v.size() == v.capacity()) {
+      v.reserve(std::max<size_t>(1, 2 * v.capacity()));
+    }
+  }
+
+  std::vector<T> values_;
+  // slot_of_[i] is the slot of values_[i], which Erase needs to fix up the
+  // slot of the value it moves.
+  std::vector<uint32_t> slot_of_;
+  std::vector<Slot> slots_;
+  uint32_t free_head_;
+};
+
+// The Point class from unique_ptr.cpp.
+class Point {
+ public:
+  Point() : x_(0), y_(0) {}
+  Point(int x, int y) : x_(x), y_(y) {}
+  int GetX() const { return x_; }
+  int GetY() const { return y_; }
+  void SetX(int x) { x_ = x; }
+  void SetY(int y) { y_ = y; }
+
+ private:
+  int x_;
+  int y_;
+};
+
+template <typename Fn>
+double TimeMs(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  SlotMap<Point> points;
+  Handle a = points.Emplace(1, 2);
+  Handle b = points.Emplace(3, 4);
+  Handle c = points.Emplace(5, 6);
+  points.Get(b)->SetX(445);
+  std::cout << "b = (" << points.Get(b)->GetX() << ", " << points.Get(b)->GetY() << ")\n";
+
+  // Erasing a moves c into a's place, but c's handle still finds it.
+  points.Erase(a);
+  std::cout << "After erasing a: a is " << (points.Contains(a) ? "live" : "stale") << ", c = ("
+            << points.Get(c)->GetX() << ", " << points.Get(c)->GetY() << ")\n";
+  // The new value reuses a's slot with a new generation, so a stays stale.
+  Handle d = points.Emplace(7, 8);
+  std::cout << "d reuses slot " << d.index_ << " (a had slot " << a.index_ << "), a is still "
+            << (points.Get(a) == nullptr ? "stale" : "live") << "\n";
+  std::cout << "Live points:";
+  for (const Point &point : points) {
+    std::cout << " (" << point.GetX() << ", " << point.GetY() << ")";
+  }
+  std::cout << "\n\n";
+
+  // A million Points with churn: create them, destroy a random half, and
+  // create that many again, so both layouts see the fragmentation of a long
+  // running program.
+  const size_t count = 1000000;
+  std::mt19937 rng(445);
+
+  std::vector<std::unique_ptr<Point>> owned;
+  std::vector<std::unique_ptr<int[]>> other_allocations;
+  SlotMap<Point> dense;
+  std::vector<Handle> handles;
+  dense.Reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    owned.push_back(std::make_unique<Point>(static_cast<int>(i), 1));
+    // Other allocations in between, as the rest of a program would make.
+    other_allocations.push_back(std::make_unique<int[]>(1 + rng() % 16));
+    handles.push_back(dense.Emplace(static_cast<int>(i), 1));
+  }
+  // Shuffle both with the same permutation, so they erase the same Points.
+  std::mt19937 same_rng = rng;
+  std::shuffle(owned.begin(), owned.end(), rng);
+  std::shuffle(handles.begin(), handles.end(), same_rng);
+  for (size_t i = 0; i < count / 2; i++) {
+    owned[i] = std::make_unique<Point>(static_cast<int>(i), 2);
+    dense.Erase(handles[i]);
+    handles[i] = dense.Emplace(static_cast<int>(i), 2);
+  }
+  other_allocations.clear();
+
+  long long owned_sum = 0;
+  long long dense_sum = 0;
+  double owned_ms = TimeMs([&] {
+    for (const auto &point : owned) {
+      owned_sum += point->GetX() + point->GetY();
+    }
+  });
+  double dense_ms = TimeMs([&] {
+    for (const Point &point : dense) {
+      dense_sum += point.GetX() + point.GetY();
+    }
+  });
+  std::cout << "Iterate " << count << " points: vector<unique_ptr<Point>> " << owned_ms << " ms (sum " << owned_sum
+            << "), SlotMap " << dense_ms << " ms (sum " << dense_sum << ")\n";
+
+  // Lookups by handle in random order cost one extra indirection through
+  // the slot, but the slots and values are both compact.
+  long long lookup_sum = 0;
+  double lookup_ms = TimeMs([&] {
+    for (Handle handle : handles) {
+      lookup_sum += dense.Get(handle)->GetX();
+    }
+  });
+  std::cout << "Look up " << count << " points by handle: " << lookup_ms << " ms (sum " << lookup_sum << ")\n";
+
+  return 0;
+}
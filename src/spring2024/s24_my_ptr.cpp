@@ -1,6 +1,9 @@
 #include <iostream>
 #include <memory>
 #include <utility>
+#include <vector>
+
+#include "s24_my_ptr.h"
 
 // This file contains the code used in the Spring2024 15-445/645 C++ bootcamp.
 // It dives deeply into C++ new features like move constructor/assign operator, move semantics, unique_ptr,
@@ -10,60 +13,9 @@
 //   1. please read `move_semantics.cpp` and `move_constructors.cpp` in `src` before reading this file!
 //   2. please BEGIN your reading from the MAIN function!
 
-// It is our implementation of std::unique_pointer<T>, and the real implementation is more complex!
-// A template allows us to replace any type T, with what we want later in our code.
-template <typename T>
-class Pointer {
- public:
-  Pointer() {
-    ptr_ = new T;
-    *ptr_ = 0;
-    std::cout << "New object on the heap: " << *ptr_ << std::endl;
-  }
-  Pointer(T val) {
-    ptr_ = new T;
-    *ptr_ = val;
-    std::cout << "New object on the heap: " << val << std::endl;
-  }
-  // Destructor is called whenever an instance gets out of scope (just when the stack pops).
-  ~Pointer() {
-    if (ptr_) {
-      std::cout << "Freed: " << *ptr_ << std::endl;
-      delete ptr_;
-    }
-  }
-
-  // Copy constructor is explicitly deleted.
-  Pointer(const Pointer<T> &) = delete;
-  // Copy assignment operator is explicitly deleted.
-  Pointer<T> &operator=(const Pointer<T> &) = delete;
-
-  // Add move constructor: useful when we need to EXTEND the lifetime of an object!
-  Pointer<T>(Pointer<T> &&another) : ptr_(another.ptr_) { another.ptr_ = nullptr; }
-  // Add move assign operator: useful when we need to EXTEND the lifetime of an object!
-  Pointer<T> &operator=(Pointer<T> &&another) {
-    if (ptr_ == another.ptr_) {  // In case `p = std::move(p);`
-      return *this;
-    }
-    if (ptr_) {  // We must free the existing pointer before overwriting it! Otherwise we LEAK!!
-      delete ptr_;
-    }
-    ptr_ = another.ptr_;
-    another.ptr_ = nullptr;  // NOTE: L14 avoids freeing nullptr during the destruction.
-    return *this;
-  }
-
-  // Overload operator *, in order to make the Pointer<T> feel like a "pointer".
-  // Note that the line below is an example of the following syntax we can use with our unique ptr type.
-  // `p1.set_val(10)` -> `*p1 = 10`
-  T &operator*() { return *ptr_; }
-
-  T get_val() { return *ptr_; }
-  void set_val(T val) { *ptr_ = val; }
-
- private:
-  T *ptr_;
-};
+// Our own unique_ptr, Pointer<T>, is in s24_my_ptr.h, together with its policies (where its object comes from, and
+// what it reports about it) and SmallPointer<T>. They live in a header so that s24_my_ptr_bench.cpp and
+// owning_ptr_bench.cpp, which are built with optimizations, time the very same code. Please read it after main.
 
 // INCORRECT version of smart_generator
 template <typename T>
@@ -249,5 +201,52 @@ int main() {
   std::shared_ptr<int> sp4{sp3};
   // 2. Always use std::make_shared() to create a shared_ptr.
 
+  /* ======================================================================
+     === Part 5: Choosing where the memory comes from =====================
+     ====================================================================== */
+  // Every Pointer<T> above used HeapPolicy, i.e. `new` and `delete`. A hot object that is created and destroyed all
+  // the time can come from a per-thread pool instead, just by changing a template argument.
+  {
+    Pointer<int, ThreadPoolPolicy<int>> pooled(7);
+    Pointer<int, ThreadPoolPolicy<int>> moved = std::move(pooled);
+    std::cout << "Hi from pooled " << moved.get_val() << std::endl;
+  }
+
+  // How much faster the pool is shows in s24_my_ptr_bench.cpp, which is built with optimizations: timings of this
+  // Debug build would say little.
+
+  /* ======================================================================
+     === Part 6: Not allocating at all ====================================
+     ====================================================================== */
+  // For an int, even a pool is overkill: SmallPointer<int> keeps the int where the pointer would be. It owns its value
+  // and moves just like Pointer<int>, but never calls malloc.
+  SmallPointer<int> s1(42);
+  SmallPointer<int> s2 = std::move(s1);
+  *s2 += 1;
+  std::cout << "Hi from inline s2 " << s2.get_val() << std::endl;
+  // A big T still lives on the heap, and moving only hands over the pointer.
+  SmallPointer<std::vector<int>> s3(std::vector<int>(1000, 1));
+  SmallPointer<std::vector<int>> s4 = std::move(s3);
+  std::cout << "Hi from heap s4, holding " << (*s4).size() << " ints" << std::endl;
+
+  // s24_my_ptr_bench.cpp times a million of them against std::unique_ptr<int>.
+
+  /* ======================================================================
+     === Part 7: Tracing without printing =================================
+     ====================================================================== */
+  // All the "New object on the heap" and "Freed" lines above come from LogTracePolicy, the default in Debug builds.
+  // CountingTracePolicy only bumps counters, and prints a single summary line for Pointer<double> when main returns.
+  {
+    using CountedPointer = Pointer<double, HeapPolicy<double>, CountingTracePolicy<double>>;
+    std::vector<CountedPointer> counted;
+    for (int i = 0; i < 1000; i++) {
+      counted.emplace_back(i * 0.5);
+    }
+    CountedPointer last = std::move(counted.back());
+  }
+
+  // With NoTracePolicy, Pointer costs exactly one allocation and one free per object, and no I/O. s24_my_ptr_bench.cpp
+  // times it.
+
   return 0;
 }
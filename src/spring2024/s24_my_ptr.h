@@ -0,0 +1,313 @@
+#pragma once
+
+#include <cxxabi.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Pointer<T>, the unique_ptr we build in s24_my_ptr.cpp, with its policies, and SmallPointer<T>. They live in this
+// header so that s24_my_ptr_bench.cpp and owning_ptr_bench.cpp, which are built with optimizations, time the very same
+// code as the tutorial.
+
+// Allocation policies decide where a Pointer<T> gets its object from, and how it gives it back: Allocate() plays the
+// role of `new T`, and Deallocate() the role of `delete` (it is the deleter, the same job std::unique_ptr's second
+// template argument does). Both live in one policy because memory must go back to where it came from.
+// The policies are stateless and only have static functions, so a Pointer stores nothing but its raw pointer.
+
+// The default policy: plain `new T` / `delete`, on the global heap.
+template <typename T>
+struct HeapPolicy {
+  static T *Allocate() { return new T; }
+  static void Deallocate(T *ptr) { delete ptr; }
+};
+
+// A per-thread pool. Each thread carves objects out of its own chunks of memory and keeps freed objects on its own
+// free list, so allocating is a pop and freeing is a push, without any locking or trip to malloc.
+// The catch: a thread's chunks are released when the thread exits, so every object must be freed, by the thread that
+// allocated it, before then.
+template <typename T>
+struct ThreadPoolPolicy {
+  static T *Allocate() { return new (LocalPool().Pop()) T; }
+
+  static void Deallocate(T *ptr) {
+    ptr->~T();
+    LocalPool().Push(ptr);
+  }
+
+ private:
+  // A free slot doubles as a free list link, so the pool needs no memory besides the objects themselves.
+  union Slot {
+    Slot *next_;
+    alignas(T) unsigned char storage_[sizeof(T)];
+  };
+
+  class Pool {
+   public:
+    static constexpr size_t kSlotsPerChunk = 4096;
+
+    ~Pool() {
+      for (Slot *chunk : chunks_) {
+        delete[] chunk;
+      }
+    }
+
+    void *Pop() {
+      if (free_ == nullptr) {
+        Grow();
+      }
+      Slot *slot = free_;
+      free_ = slot->next_;
+      return slot;
+    }
+
+    void Push(void *ptr) {
+      auto *slot = static_cast<Slot *>(ptr);
+      slot->next_ = free_;
+      free_ = slot;
+    }
+
+   private:
+    void Grow() {
+      Slot *chunk = new Slot[kSlotsPerChunk];
+      chunks_.push_back(chunk);
+      for (size_t i = 0; i < kSlotsPerChunk; i++) {
+        chunk[i].next_ = free_;
+        free_ = &chunk[i];
+      }
+    }
+
+    Slot *free_ = nullptr;
+    std::vector<Slot *> chunks_;
+  };
+
+  static Pool &LocalPool() {
+    thread_local Pool pool;
+    return pool;
+  }
+};
+
+// Tracing policies decide what Pointer<T> reports about its objects. Printing every allocation is great for learning
+// (it is what you see when you run this file), but `std::endl` flushes the output on every call, which makes a
+// Pointer far too slow for real code. So the printing is a policy too:
+//   - NoTracePolicy does nothing. Its functions are empty, so after inlining they compile to nothing at all.
+//   - LogTracePolicy prints every construction and destruction, like the original Pointer did.
+//   - CountingTracePolicy counts live objects, allocations and moves per type T, with lock-free atomic counters, and
+//     prints one summary line per type when the program exits.
+template <typename T>
+struct NoTracePolicy {
+  static void Constructed(const T &) {}
+  static void Destroyed(const T &) {}
+  static void Moved() {}
+};
+
+template <typename T>
+struct LogTracePolicy {
+  static void Constructed(const T &val) { std::cout << "New object on the heap: " << val << std::endl; }
+  static void Destroyed(const T &val) { std::cout << "Freed: " << val << std::endl; }
+  static void Moved() {}
+};
+
+template <typename T>
+struct CountingTracePolicy {
+  static void Constructed(const T &) {
+    counters_.live_.fetch_add(1, std::memory_order_relaxed);
+    counters_.allocations_.fetch_add(1, std::memory_order_relaxed);
+  }
+  static void Destroyed(const T &) { counters_.live_.fetch_sub(1, std::memory_order_relaxed); }
+  static void Moved() { counters_.moves_.fetch_add(1, std::memory_order_relaxed); }
+
+ private:
+  // One instance per type T. Its destructor runs at program exit and prints the summary.
+  struct Counters {
+    ~Counters() {
+      std::cout << "Pointer<" << TypeName() << "> summary: " << allocations_.load() << " allocations, "
+                << moves_.load() << " moves, " << live_.load() << " still live" << std::endl;
+    }
+
+    // typeid(T).name() is the mangled name, like "d" for double. The C++ ABI library that GCC and Clang share can
+    // turn it back into C++.
+    static std::string TypeName() {
+      int status;
+      std::unique_ptr<char, void (*)(void *)> name(abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status),
+                                                   std::free);
+      return status == 0 ? name.get() : typeid(T).name();
+    }
+
+    std::atomic<long> live_{0};
+    std::atomic<long> allocations_{0};
+    std::atomic<long> moves_{0};
+  };
+
+  static inline Counters counters_;
+};
+
+// Debug builds (like this bootcamp's) log every object; release builds (-DNDEBUG) trace nothing and do no I/O.
+#ifdef NDEBUG
+template <typename T>
+using DefaultTracePolicy = NoTracePolicy<T>;
+#else
+template <typename T>
+using DefaultTracePolicy = LogTracePolicy<T>;
+#endif
+
+// It is our implementation of std::unique_pointer<T>, and the real implementation is more complex!
+// A template allows us to replace any type T, with what we want later in our code. The AllocPolicy template parameter
+// is how std::unique_ptr<T, Deleter> works too: the policy is picked at compile time, and costs nothing at runtime.
+// TracePolicy works the same way.
+template <typename T, typename AllocPolicy = HeapPolicy<T>, typename TracePolicy = DefaultTracePolicy<T>>
+class Pointer {
+ public:
+  Pointer() {
+    ptr_ = AllocPolicy::Allocate();
+    *ptr_ = 0;
+    TracePolicy::Constructed(*ptr_);
+  }
+  Pointer(T val) {
+    ptr_ = AllocPolicy::Allocate();
+    *ptr_ = val;
+    TracePolicy::Constructed(*ptr_);
+  }
+  // Destructor is called whenever an instance gets out of scope (just when the stack pops).
+  ~Pointer() {
+    if (ptr_) {
+      TracePolicy::Destroyed(*ptr_);
+      AllocPolicy::Deallocate(ptr_);
+    }
+  }
+
+  // Inside the class, `Pointer` alone means this exact type, policy included. (`Pointer<T>` would always mean the
+  // default policy!)
+  // Copy constructor is explicitly deleted.
+  Pointer(const Pointer &) = delete;
+  // Copy assignment operator is explicitly deleted.
+  Pointer &operator=(const Pointer &) = delete;
+
+  // Add move constructor: useful when we need to EXTEND the lifetime of an object!
+  Pointer(Pointer &&another) noexcept : ptr_(another.ptr_) {
+    another.ptr_ = nullptr;
+    TracePolicy::Moved();
+  }
+  // Add move assign operator: useful when we need to EXTEND the lifetime of an object!
+  Pointer &operator=(Pointer &&another) noexcept {
+    if (ptr_ == another.ptr_) {  // In case `p = std::move(p);`
+      return *this;
+    }
+    if (ptr_) {  // We must free the existing pointer before overwriting it! Otherwise we LEAK!!
+      TracePolicy::Destroyed(*ptr_);
+      AllocPolicy::Deallocate(ptr_);
+    }
+    ptr_ = another.ptr_;
+    another.ptr_ = nullptr;  // NOTE: L14 avoids freeing nullptr during the destruction.
+    TracePolicy::Moved();
+    return *this;
+  }
+
+  // Overload operator *, in order to make the Pointer<T> feel like a "pointer".
+  // Note that the line below is an example of the following syntax we can use with our unique ptr type.
+  // `p1.set_val(10)` -> `*p1 = 10`
+  T &operator*() { return *ptr_; }
+
+  T get_val() { return *ptr_; }
+  void set_val(T val) { *ptr_ = val; }
+
+ private:
+  T *ptr_;
+};
+
+// Stateless policies add zero bytes: a Pointer is exactly as big as the raw pointer it owns.
+static_assert(sizeof(Pointer<int>) == sizeof(int *));
+static_assert(sizeof(Pointer<int, ThreadPoolPolicy<int>>) == sizeof(int *));
+static_assert(sizeof(Pointer<int, HeapPolicy<int>, CountingTracePolicy<int>>) == sizeof(int *));
+// Moving only hands over the raw pointer, so it cannot fail. Saying so with `noexcept` matters: containers like
+// std::vector only move their elements when they grow if the move cannot throw (see std::move_if_noexcept).
+static_assert(std::is_nothrow_move_constructible_v<Pointer<int>> && std::is_nothrow_move_assignable_v<Pointer<int>>);
+
+// Pointer<int> spends a whole heap allocation (and a pointer to it) on 4 bytes of data. SmallPointer<T> is an owning
+// pointer with small buffer optimization (SBO), the trick std::string and std::function use: a T that fits in the
+// space of the pointer itself is stored right there, inline, and only a bigger T goes to AllocPolicy.
+// Whether T is stored inline is decided at compile time from its size and alignment, so there is no runtime flag, and
+// a SmallPointer is always exactly as big as a raw pointer.
+template <typename T, typename AllocPolicy = HeapPolicy<T>>
+class SmallPointer {
+ public:
+  // Only types that can be moved without throwing are stored inline, since moving the SmallPointer moves them.
+  static constexpr bool kInline =
+      sizeof(T) <= sizeof(T *) && alignof(T) <= alignof(T *) && std::is_nothrow_move_constructible_v<T>;
+
+  SmallPointer() : SmallPointer(T{}) {}
+  SmallPointer(T val) {
+    if constexpr (kInline) {
+      new (storage_) T(std::move(val));
+    } else {
+      ptr_ = AllocPolicy::Allocate();
+      *ptr_ = std::move(val);
+    }
+  }
+  ~SmallPointer() { Reset(); }
+
+  SmallPointer(const SmallPointer &) = delete;
+  SmallPointer &operator=(const SmallPointer &) = delete;
+
+  // Moving follows the relocation rules. A heap T is not touched at all: the pointer changes owner, as in Pointer.
+  // An inline T has to be moved into the new buffer. If T is trivially copyable that is a plain copy of the bytes;
+  // otherwise T's move constructor runs. Either way, the moved-from SmallPointer still holds a (moved-from) T, like a
+  // moved-from std::string, and destroys it normally.
+  SmallPointer(SmallPointer &&another) noexcept {
+    if constexpr (!kInline) {
+      ptr_ = another.ptr_;
+      another.ptr_ = nullptr;
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memcpy(storage_, another.storage_, sizeof(T));
+    } else {
+      new (storage_) T(std::move(*another.Get()));
+    }
+  }
+  SmallPointer &operator=(SmallPointer &&another) noexcept {
+    if (this != &another) {
+      Reset();
+      new (this) SmallPointer(std::move(another));
+    }
+    return *this;
+  }
+
+  T &operator*() { return *Get(); }
+
+  T get_val() { return *Get(); }
+  void set_val(T val) { *Get() = val; }
+
+ private:
+  T *Get() {
+    if constexpr (kInline) {
+      return std::launder(reinterpret_cast<T *>(storage_));
+    } else {
+      return ptr_;
+    }
+  }
+
+  void Reset() {
+    if constexpr (kInline) {
+      Get()->~T();
+    } else if (ptr_) {
+      AllocPolicy::Deallocate(ptr_);
+      ptr_ = nullptr;
+    }
+  }
+
+  union {
+    T *ptr_;
+    alignas(T *) unsigned char storage_[sizeof(T *)];
+  };
+};
+
+static_assert(SmallPointer<int>::kInline && SmallPointer<char>::kInline && SmallPointer<float>::kInline);
+static_assert(!SmallPointer<std::vector<int>>::kInline);
+static_assert(sizeof(SmallPointer<int>) == sizeof(int *) && sizeof(SmallPointer<std::vector<int>>) == sizeof(int *));
@@ -21,93 +21,16 @@
 // In this file, we will look at a basic implementation of a wrapper class that
 // manages an int*. We will also look at usage of this class.
 
+// Includes the IntPtrManager class, a wrapper class that manages an int*.
+// It lives in a header so that owning_ptr_bench.cpp can time the very same
+// class. Please read it before main below.
+#include "wrapper_class.h"
+
 // Includes std::cout (printing) for demo purposes.
 #include <iostream>
 // Includes the utility header for std::move.
 #include <utility>
 
-// The IntPtrManager class is a wrapper class that manages an int*. The
-// resource that this class is managing is the dynamic memory accessible via
-// the pointer ptr_. By the principles of the RAII technique, a wrapper class
-// object should not be copyable, since one object is supposed to manage one
-// resource. Therefore, the copy assignment operator and copy constructor are
-// deleted from this class. However, the class is still moveable from different
-// lvalues/owners, and has a move constructor and move assignment operator.
-// Another reason that wrapper classes forbid copying is because they destroy
-// their resource in the destructor, and if two objects are managing the same
-// resource, there is a risk of double deletion of the resource.
-class IntPtrManager {
-  public:
-    // All constructors of a wrapper class are supposed to initialize a resource.
-    // In this case, this means allocating the memory that we are managing.
-    // The default value of this pointer's data is 0.
-    IntPtrManager() {
-      ptr_ = new int;
-      *ptr_ = 0;
-    }
-
-    // Another constructor for this wrapper class that takes a initial value.
-    IntPtrManager(int val) {
-      ptr_ = new int;
-      *ptr_ = val;
-    }
-
-    // Destructor for the wrapper class. The destructor must destroy the
-    // resource that it is managing; in this case, the destructor deletes
-    // the pointer!
-    ~IntPtrManager() {
-      // Note that since the move constructor marks objects invalid by setting
-      // their ptr_ value to nullptr, we have to account for this in the 
-      // destructor. We don't want to be calling delete on a nullptr!
-      if (ptr_) {
-        delete ptr_;
-      }
-    }
-
-    // Move constructor for this wrapper class. Note that after the move
-    // constructor is called, effectively moving all of other's data into
-    // the specified instance being constructed, the other object is no
-    // longer a valid instance of the IntPtrManager class, since it has
-    // no memory to manage. 
-    IntPtrManager(IntPtrManager&& other) {
-      ptr_ = other.ptr_;
-      other.ptr_ = nullptr;
-    }
-
-    // Move assignment operator for this wrapper class. Similar techniques as
-    // the move constructor.
-    IntPtrManager &operator=(IntPtrManager &&other) {
-      if (ptr_ == other.ptr_) {
-        return *this;
-      }
-      if (ptr_) {
-        delete ptr_;
-      }
-      ptr_ = other.ptr_;
-      other.ptr_ = nullptr;
-      return *this;
-    }
-
-    // We delete the copy constructor and the copy assignment operator,
-    // so this class cannot be copy-constructed. 
-    IntPtrManager(const IntPtrManager &) = delete;
-    IntPtrManager &operator=(const IntPtrManager &) = delete;
-
-    // Setter function.
-    void SetVal(int val) {
-      *ptr_ = val;
-    }
-
-    // Getter function.
-    int GetVal() const {
-      return *ptr_;
-    }
-
-  private:
-    int *ptr_;
-
-};
-
 int main() {
   // We initialize an instance of IntPtrManager. After it is initialized, this
   // class is managing an int pointer.